@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Game {
+
+// Buddy sub-allocator over an abstract range of size bytes. Every allocation is rounded up to a power
+// of two, which also makes its offset aligned to any power-of-two alignment up to that size.
+class BuddyAllocator {
+private:
+    uint32_t minOrder;
+    uint32_t maxOrder;
+    std::vector<std::unordered_set<uint64_t>> freeLists;
+    std::unordered_map<uint64_t, uint32_t> allocatedOrders;
+    uint64_t usedBytes = 0;
+
+public:
+    static constexpr uint64_t InvalidOffset = ~0ull;
+
+    // size and minBlockSize must be powers of two.
+    BuddyAllocator(uint64_t size, uint64_t minBlockSize);
+
+    uint64_t allocate(uint64_t size, uint64_t alignment);
+    // Returns the number of bytes released.
+    uint64_t free(uint64_t offset);
+
+    uint64_t getSize() const { return 1ull << maxOrder; }
+    uint64_t getUsedBytes() const { return usedBytes; }
+    size_t getAllocationCount() const { return allocatedOrders.size(); }
+    bool empty() const { return allocatedOrders.empty(); }
+    // Size of the largest free range, i.e. the largest request that can still succeed.
+    uint64_t getLargestFreeBlock() const;
+
+    // Calls fn(offset, size) for every live allocation, in no particular order.
+    template<typename Fn>
+    void forEachAllocation(Fn&& fn) const {
+        for (const auto& [offset, order] : allocatedOrders) {
+            fn(offset, 1ull << order);
+        }
+    }
+};
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "gpu_allocator.hpp"
+
+namespace Game {
+
+enum class CaptureFormat {
+    Png,
+    // Tightly packed RGBA8 rows with the size in the file name.
+    Raw
+};
+
+struct CaptureSettings {
+    // Every interval-th frame is captured; 0 disables capture.
+    uint32_t interval = 0;
+    std::string directory = "captures";
+    CaptureFormat format = CaptureFormat::Png;
+};
+
+// Reads rendered frames back without stalling the GPU. The copy into a host-visible buffer is recorded
+// into the frame's own command buffer, the pixels are picked up once that frame's fence has signaled
+// anyway, and files are encoded and written on a background thread. Images must be 4 bytes per pixel.
+class FrameCapture {
+private:
+    struct Readback {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        bool pending = false;
+        uint64_t frameNumber = 0;
+    };
+
+    struct PendingWrite {
+        uint64_t frameNumber;
+        std::vector<uint8_t> pixels;
+    };
+
+    spdlog::logger captureLogger;
+    GpuAllocator& allocator;
+    VkExtent2D extent;
+    CaptureSettings settings;
+    std::vector<Readback> readbacks;
+
+    std::mutex writeMutex;
+    std::condition_variable_any writeCondition;
+    std::deque<PendingWrite> writeQueue;
+    uint64_t writtenFrames = 0;
+    std::jthread writer;
+
+    void writeLoop(std::stop_token stopToken);
+    void write(const PendingWrite& pending);
+
+public:
+    FrameCapture(GpuAllocator& allocator, uint32_t framesInFlight, VkExtent2D extent, const CaptureSettings& settings);
+    // Waits for every queued file to be written.
+    ~FrameCapture();
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    bool shouldCapture(uint64_t frameNumber) const;
+    // image must be in TRANSFER_SRC_OPTIMAL layout when the copy executes.
+    void recordCopy(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber, VkImage image);
+    // Hands the pixels of frame's last capture to the writer. Only once frame's fence has signaled.
+    void collect(uint32_t frame);
+};
+
+}
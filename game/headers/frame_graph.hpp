@@ -0,0 +1,93 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <vector>
+#include "rendering/render_graph.hpp"
+#include "spdlog/spdlog.h"
+#include "gpu_allocator.hpp"
+#include "gpu_profiler.hpp"
+
+namespace Game {
+
+// Vulkan backend for Rendering::RenderGraph. Creates the graph's transient images and buffers, places
+// each alias slot in one device-local allocation, and records every surviving pass behind the barriers
+// the graph computed.
+class FrameGraph {
+private:
+    struct PhysicalResource {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkImageAspectFlags aspect = 0;
+        VkBuffer buffer = VK_NULL_HANDLE;
+    };
+
+    struct TransientKey {
+        Rendering::RenderResourceType type;
+        Rendering::TextureDesc texture;
+        uint64_t size;
+        Rendering::AccessMask usage;
+
+        bool operator==(const TransientKey&) const = default;
+    };
+
+    // The transients of one frame in flight. They are kept for as long as the graph declares the same
+    // transients and packs them into the same slots, which is every frame for a stable graph.
+    struct TransientSet {
+        std::vector<TransientKey> keys;
+        std::vector<PhysicalResource> resources;
+        std::vector<Rendering::MemoryRequirement> requirements;
+        std::vector<int32_t> slots;
+        std::vector<GpuAllocation> memory;
+        bool bound = false;
+    };
+
+    spdlog::logger frameGraphLogger;
+    VkDevice device;
+    GpuAllocator& allocator;
+    Rendering::RenderGraph graph;
+    std::vector<std::function<void(VkCommandBuffer)>> passCallbacks;
+    std::vector<PhysicalResource> physical;
+    std::vector<TransientSet> frames;
+    uint32_t currentFrame = 0;
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+    void createTransients(TransientSet& set);
+    void destroyTransients(TransientSet& set);
+    void bindTransients(TransientSet& set, const std::vector<Rendering::RenderResource>& transients);
+    void recordBarriers(VkCommandBuffer commandBuffer, std::span<const Rendering::ResourceBarrier> barriers);
+
+public:
+    FrameGraph(VkDevice device, GpuAllocator& allocator, uint32_t framesInFlight);
+    ~FrameGraph();
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    // Starts an empty graph. Must only be called once the fence of frame's previous submission has
+    // signaled, since that frame's transients may be recreated.
+    void beginFrame(uint32_t frame);
+
+    Rendering::RenderResource importImage(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+        Rendering::ResourceAccess current, bool discard);
+    Rendering::RenderResource importBuffer(const char* name, VkBuffer buffer, VkDeviceSize size, Rendering::AccessMask current);
+    Rendering::RenderResource createImage(const char* name, VkFormat format, VkExtent2D extent);
+    Rendering::RenderResource createBuffer(const char* name, VkDeviceSize size);
+    void markOutput(Rendering::RenderResource resource, Rendering::ResourceAccess finalAccess);
+
+    // record runs during execute() if the pass survives culling; physical resources are valid by then.
+    Rendering::RenderPassHandle addPass(const char* name, std::function<void(VkCommandBuffer)> record);
+    void access(Rendering::RenderPassHandle pass, Rendering::RenderResource resource, Rendering::ResourceAccess access);
+    void setSideEffects(Rendering::RenderPassHandle pass);
+
+    // Compiles the graph and records it into commandBuffer. With a profiler every pass, including the
+    // barriers it waits on, is timed as a scope named after the pass.
+    void execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler = nullptr);
+
+    VkImage getImage(Rendering::RenderResource resource) const { return physical[resource].image; }
+    VkImageView getImageView(Rendering::RenderResource resource) const { return physical[resource].view; }
+    VkBuffer getBuffer(Rendering::RenderResource resource) const { return physical[resource].buffer; }
+    const Rendering::RenderGraph& getGraph() const { return graph; }
+};
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include "spdlog/spdlog.h"
+
+namespace Game {
+
+// Points in a frame's life, in the order they are reached.
+enum class FrameMarker : uint8_t {
+    // The limiter released the frame.
+    Begin,
+    // Window events for the frame have been polled.
+    InputSampled,
+    // The frame packet was handed to the render thread.
+    Published,
+    // The render thread picked the packet up.
+    Acquired,
+    // The fence of the frame that last used this frame-in-flight slot signaled.
+    FenceSignaled,
+    Submitted,
+    // vkQueuePresentKHR returned. The image reaches the screen later, by up to the present queue depth.
+    // Headless frames mark it right after submission.
+    Presented,
+    Count
+};
+
+// Marker timestamps of one frame. Travels with the frame from the simulation to the render thread.
+struct FrameTimeline {
+    std::array<std::chrono::steady_clock::time_point, static_cast<size_t>(FrameMarker::Count)> markers{};
+    double limiterWait = 0.0;
+
+    void mark(FrameMarker marker) { markers[static_cast<size_t>(marker)] = std::chrono::steady_clock::now(); }
+    double elapsed(FrameMarker from, FrameMarker to) const;
+};
+
+// Caps the frame rate and reports latency markers. The limiter sleeps in short steps until the wake-up
+// is closer than the measured oversleep of one step, then yields for the remainder, which keeps it
+// accurate to well under a millisecond without burning a core. Marker statistics are logged once per
+// reportInterval. waitForNextFrame and endFrame touch disjoint state, so the simulation thread may
+// call one while the render thread calls the other.
+class FramePacer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    spdlog::logger pacerLogger;
+    Clock::duration targetFrameTime;
+    Clock::time_point nextFrame;
+
+    // Exponentially weighted mean and variance of how long a 1 ms sleep really takes.
+    double sleepEstimate = 0.002;
+    double sleepMean = 0.002;
+    double sleepVariance = 0.0;
+
+    Clock::duration reportInterval;
+    Clock::time_point reportStart;
+    uint32_t reportFrames = 0;
+    double limiterTotal = 0.0;
+    double handoffTotal = 0.0;
+    double fenceWaitTotal = 0.0;
+    double inputToPresentTotal = 0.0;
+    double inputToPresentMax = 0.0;
+
+    void sleepUntil(Clock::time_point target);
+
+public:
+    // frameRateLimit 0 disables the limiter; markers are recorded either way.
+    explicit FramePacer(double frameRateLimit, std::chrono::milliseconds reportInterval = std::chrono::seconds(1));
+    ~FramePacer();
+
+    // Blocks until the next frame may start and marks FrameMarker::Begin on timeline.
+    void waitForNextFrame(FrameTimeline& timeline);
+    // Folds a frame's markers into the statistics. Frames that skipped a marker, e.g. because the
+    // swapchain was out of date, must not call this.
+    void endFrame(const FrameTimeline& timeline);
+};
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "rendering/instance_batcher.hpp"
+#include "frame_pacer.hpp"
+
+namespace Game {
+
+// Per-view data, written once per frame into the frame ring and bound with a dynamic offset.
+struct CameraUniform {
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 proj;
+    // World-space planes of proj * view with normalised normals pointing inwards, for culling.
+    alignas(16) glm::vec4 frustumPlanes[6];
+};
+
+// Everything the render thread needs to draw one frame, extracted from the ECS on the simulation
+// thread. Once published the render thread only adds markers to timeline.
+struct FramePacket {
+    CameraUniform camera;
+    std::vector<Rendering::InstanceData> instances;
+    std::vector<Rendering::InstanceBatch> batches;
+    // Drawable size of the window when the packet was built; zero while minimized.
+    VkExtent2D windowExtent{};
+    bool windowResized = false;
+    FrameTimeline timeline;
+};
+
+// Hands frame packets from the simulation thread to the render thread. Packets cycle between a free
+// list and a ready queue, so with two packets the simulation fills frame N + 1 while frame N is
+// recorded and submitted; more packets let it run further ahead at the cost of latency. Packets keep
+// their vectors between frames, so a steady scene extracts without allocating.
+class FramePacketQueue {
+private:
+    spdlog::logger queueLogger;
+    std::vector<FramePacket> packets;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<FramePacket*> freePackets;
+    std::deque<FramePacket*> readyPackets;
+    bool closed = false;
+
+public:
+    explicit FramePacketQueue(uint32_t packetCount);
+    ~FramePacketQueue();
+    FramePacketQueue(const FramePacketQueue&) = delete;
+    FramePacketQueue& operator=(const FramePacketQueue&) = delete;
+
+    // Simulation side. Blocks until a packet is free; null once the queue is closed.
+    FramePacket* beginWrite();
+    void publish(FramePacket& packet);
+
+    // Render side. Blocks until a packet is ready; null once the queue is closed and drained.
+    FramePacket* acquire();
+    void release(FramePacket& packet);
+
+    // Wakes both sides for good. Packets published before are still handed out.
+    void close();
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstring>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "gpu_allocator.hpp"
+
+namespace Game {
+
+struct FrameAllocation {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    void* mapped;
+};
+
+// One persistently mapped, host-visible buffer that per-frame vertex, index, uniform and instance data
+// is linearly sub-allocated from. Space written during a frame is reclaimed by beginFrame() the next
+// time that frame slot comes around, i.e. right after its in-flight fence has been waited on. The ring
+// holds framesInFlight + 1 frames of frameSize bytes: the extra frame covers the tail an allocation
+// skips when it would wrap, so frames that stay within frameSize never run out of space.
+class FrameRingBuffer {
+private:
+    spdlog::logger ringLogger;
+    GpuAllocator& allocator;
+    VkBuffer buffer;
+    GpuAllocation memory;
+    VkDeviceSize capacity;
+    VkDeviceSize minAlignment;
+    VkDeviceSize head = 0;
+    VkDeviceSize used = 0;
+    std::vector<VkDeviceSize> frameConsumed;
+    uint32_t currentFrame = 0;
+
+public:
+    // minAlignment should cover the device's uniform and storage buffer offset alignments. frameSize is
+    // the most a single frame allocates, alignment padding included.
+    FrameRingBuffer(GpuAllocator& allocator, uint32_t framesInFlight, VkDeviceSize minAlignment, VkDeviceSize frameSize);
+    ~FrameRingBuffer();
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+    // Must only be called once the fence of frame's previous submission has signaled.
+    void beginFrame(uint32_t frame);
+    FrameAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+    template<typename T>
+    FrameAllocation push(const T& value) {
+        FrameAllocation allocation = allocate(sizeof(T), alignof(T));
+        std::memcpy(allocation.mapped, &value, sizeof(T));
+        return allocation;
+    }
+
+    VkBuffer getBuffer() const { return buffer; }
+    VkDeviceSize getUsedBytes() const { return used; }
+};
+
+}
@@ -16,8 +16,23 @@
 #include <optional>
 #include <set>
 #include <array>
+#include <exception>
+#include <thread>
 
 #include "vulkan_wrapper.hpp"
+#include "game_engine.hpp"
+#include "rendering/instance_batcher.hpp"
+#include "frame_capture.hpp"
+#include "frame_graph.hpp"
+#include "frame_pacer.hpp"
+#include "frame_packet.hpp"
+#include "frame_ring_buffer.hpp"
+#include "gpu_allocator.hpp"
+#include "gpu_profiler.hpp"
+#include "graphics_pipeline_cache.hpp"
+#include "parallel_command_recorder.hpp"
+#include "pipeline_cache.hpp"
+#include "upload_manager.hpp"
 
 namespace Game {
 
@@ -43,6 +58,8 @@ const bool enableValidationLayers = true;
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // Only set for a transfer-only family, which maps to the GPU's dedicated copy engines.
+    std::optional<uint32_t> transferFamily;
 
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
@@ -85,12 +102,48 @@ struct Vertex {
     }
 };
 
-struct UniformBufferObject {
-    alignas(16) glm::mat4 model;
-    alignas(16) glm::mat4 view;
-    alignas(16) glm::mat4 proj;
+// Caps on what a single frame can cull and draw. MaxDrawBatches and DrawBucketSize must match the
+// culling shaders. Each bucket of DrawBucketSize batches is recorded into its own secondary buffer.
+constexpr uint32_t MaxDrawBatches = 256;
+// Instance data each frame in flight may place in the frame ring, which is sized from it. Scenes with
+// more instances draw the first MaxDrawInstances.
+constexpr VkDeviceSize FrameInstanceBudget = 8ull * 1024 * 1024;
+constexpr uint32_t MaxDrawInstances = static_cast<uint32_t>(FrameInstanceBudget / sizeof(Rendering::InstanceData));
+constexpr uint32_t DrawBucketSize = 32;
+constexpr uint32_t MaxDrawBuckets = MaxDrawBatches / DrawBucketSize;
+
+// Per-mesh input of the culling pass, written into the frame ring. Instances of the batch occupy
+// [firstInstance, firstInstance + instanceCount) of the frame's instance array.
+struct DrawBatch {
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    float boundingRadius;
+    uint32_t padding[2];
+};
+
+// Frame ring positions of the instance and batch arrays, in elements of their own type.
+struct CullPushConstants {
+    uint32_t instanceBase;
+    uint32_t instanceCount;
+    uint32_t batchBase;
+    uint32_t batchCount;
 };
 
+// Vulkan caps minUniformBufferOffsetAlignment and minStorageBufferOffsetAlignment at 256 bytes.
+constexpr VkDeviceSize MaxBufferOffsetAlignment = 256;
+// Frame ring bytes one frame may use: the camera, the instance array and the batch array, each of
+// which may be preceded by alignment padding.
+constexpr VkDeviceSize FrameRingFrameSize = sizeof(CameraUniform) + sizeof(Rendering::InstanceData) * MaxDrawInstances
+    + sizeof(DrawBatch) * MaxDrawBatches + 3 * MaxBufferOffsetAlignment;
+
+// Layout of drawBuffer: one draw count per bucket, one visible-instance counter per batch, then the
+// commands consumed by vkCmdDrawIndexedIndirectCount, DrawBucketSize slots per bucket.
+constexpr VkDeviceSize DrawCountersSize = sizeof(uint32_t) * (MaxDrawBuckets + MaxDrawBatches);
+constexpr VkDeviceSize DrawBufferSize = DrawCountersSize + sizeof(VkDrawIndexedIndirectCommand) * MaxDrawBatches;
+
 const std::vector<Vertex> vertices = {
     {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
     {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
@@ -102,28 +155,76 @@ const std::vector<uint16_t> indices = {
     0, 1, 2, 2, 3, 0
 };
 
+// The simulation advances in fixed steps independent of the frame rate. A frame that took longer than
+// MaxFrameDelta, e.g. after a breakpoint or a window drag, only catches up MaxFrameDelta worth of steps.
+constexpr double SimulationStep = 1.0 / 60.0;
+constexpr double MaxFrameDelta = 0.25;
+
+struct GameSettings {
+    // Renders into offscreen images without a window, surface or swapchain, e.g. on lavapipe in CI.
+    bool headless = false;
+    // Headless runs stop after this many frames; 0 never stops.
+    uint32_t frameCount = 0;
+    // Only honoured when headless.
+    CaptureSettings capture;
+    // Fewer frames in flight cut input latency, more let the CPU run further ahead of the GPU.
+    uint32_t framesInFlight = 2;
+    // Falls back to FIFO, the only mode every surface supports.
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    // Frames per second; 0 leaves the rate to the present mode and the GPU.
+    double frameRateLimit = 0.0;
+    // Frames the simulation thread may prepare ahead of the render thread, see FramePacketQueue.
+    uint32_t framePackets = 2;
+    // Chrome trace of the GPU pass timings; empty writes none.
+    std::string gpuTracePath;
+};
+
 class Game {
 public:
     void run();
-    Game(const uint32_t width, const uint32_t height);
+    Game(Engine::GameEngine& gameEngine, const uint32_t width, const uint32_t height, const GameSettings& settings = {});
+
+private: // ENGINE
+    Engine::GameEngine& gameEngine;
+    Core::Entity quadEntity;
+    double simulationTime = 0.0;
+
+private: // RUN
+    spdlog::logger gameLogger;
+    const GameSettings settings;
+    const VkExtent2D requestedExtent;
+    FramePacer framePacer;
+    // The simulation runs on the thread that called run(); everything below RUN belongs to the render
+    // thread once it has started.
+    std::unique_ptr<FramePacketQueue> framePackets;
+    std::jthread renderThread;
+    std::exception_ptr renderError;
 
 private: // SDL
-    SDLWrapper::SDL sdl;
+    // Null when headless.
+    std::unique_ptr<SDLWrapper::SDL> sdl;
 
 private: // VULKAN
-    const int MAX_FRAMES_IN_FLIGHT = 2;
+    const uint32_t framesInFlight;
     uint32_t currentFrame = 0;
     bool framebufferResized = false;
+    // The swapchain is recreated on every resize, so an unsupported present mode is only reported once.
+    bool presentModeFallbackLogged = false;
+    // Render thread copy of the window's drawable size, taken from the latest frame packet.
+    VkExtent2D windowExtent{};
     
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
-    VkSurfaceKHR surface;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
 
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice device;
+    std::unique_ptr<GpuAllocator> gpuAllocator;
 
     VkQueue graphicsQueue;
     VkQueue presentQueue;
+    VkQueue transferQueue;
+    std::unique_ptr<UploadManager> uploadManager;
 
     VkSwapchainKHR swapChain;
     std::vector<VkImage> swapChainImages;
@@ -131,34 +232,57 @@ private: // VULKAN
     VkExtent2D swapChainExtent;
     std::vector<VkImageView> swapChainImageViews;
     std::vector<VkFramebuffer> swapChainFramebuffers;
+    // Backing memory of the images standing in for the swapchain when headless.
+    std::vector<GpuAllocation> offscreenImageMemory;
+    std::unique_ptr<FrameCapture> frameCapture;
+    uint64_t frameNumber = 0;
 
     VkRenderPass renderPass;
     VkDescriptorSetLayout descriptorSetLayout;
     VkPipelineLayout pipelineLayout;
-    VkPipeline graphicsPipeline;
+    std::unique_ptr<GraphicsPipelineCache> graphicsPipelines;
+    GraphicsPipelineState meshPipelineState;
+    VkPipeline cullPipeline;
+    VkPipeline buildDrawsPipeline;
+    std::unique_ptr<PipelineCache> pipelineCache;
 
     VkCommandPool commandPool;
     std::vector<VkCommandBuffer> commandBuffers;
+    std::unique_ptr<ParallelCommandRecorder> commandRecorder;
+    std::unique_ptr<FrameGraph> frameGraph;
+    std::unique_ptr<GpuProfiler> gpuProfiler;
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
     std::vector<VkFence> inFlightFences;
 
     VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
+    GpuAllocation vertexBufferMemory;
     VkBuffer indexBuffer;
-    VkDeviceMemory indexBufferMemory;
+    GpuAllocation indexBufferMemory;
     
-    std::vector<VkBuffer> uniformBuffers;
-    std::vector<VkDeviceMemory> uniformBuffersMemory;
-    std::vector<void*> uniformBuffersMapped;
+    std::unique_ptr<FrameRingBuffer> frameRing;
+    uint32_t cameraOffset = 0;
+    std::unique_ptr<Rendering::InstanceBatcher> instanceBatcher;
+    CullPushConstants cullConstants{};
+
+    // GPU-written culling output, shared by all frames in flight and guarded by barriers instead.
+    VkBuffer drawBuffer;
+    GpuAllocation drawBufferMemory;
+    VkBuffer visibleInstanceBuffer;
+    GpuAllocation visibleInstanceBufferMemory;
 
     VkDescriptorPool descriptorPool;
-    std::vector<VkDescriptorSet> descriptorSets;
+    VkDescriptorSet cameraDescriptorSet;
 
     void initWindow();
     void initVulkan();
     void mainLoop();
+    void headlessLoop();
+    void startRenderThread();
+    void stopRenderThread();
+    void renderLoop();
+    void waitForFrame(FrameTimeline& timeline);
     void cleanup();
     void createInstance();
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
@@ -167,6 +291,7 @@ private: // VULKAN
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createSwapChain();
+    void createOffscreenTargets();
     void createImageViews();
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
@@ -181,23 +306,29 @@ private: // VULKAN
     void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator);
     VkShaderModule createShaderModule(const std::vector<char>& code);
     void createGraphicsPipeline();
+    void createCullingPipelines();
+    void createCullingBuffers();
+    void recordDrawBucket(VkCommandBuffer commandBuffer, uint32_t bucket);
     void createRenderPass();
     void createFramebuffers();
     void createCommandPool();
+    void createUploadManager();
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
     void createSyncObjects();
-    void drawFrame();
+    void simulate(float deltaTime);
+    // interpolation blends the last two simulation steps, 0 being the older one.
+    void extractFrame(FramePacket& packet, float interpolation);
+    void drawFrame(FramePacket& packet);
     void recreateSwapChain();
     void cleanupSwapChain();
     void createVertexBuffer();
-    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, GpuAllocation& bufferMemory, std::span<const uint32_t> queueFamilies = {});
     void createCommandBuffers();
     void createIndexBuffer();
     void createDescriptorSetLayout();
-    void createUniformBuffers();
-    void updateUniformBuffer(uint32_t currentImage);
+    void createFrameRingBuffer();
+    void updateCameraUniform(const FramePacket& packet);
+    void updateInstances(const FramePacket& packet);
     void createDescriptorPool();
     void createDescriptorSets();
     void createTextureImage();
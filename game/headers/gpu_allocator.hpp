@@ -0,0 +1,98 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "buddy_allocator.hpp"
+
+namespace Game {
+
+constexpr VkDeviceSize GpuBlockSize = 64ull * 1024 * 1024;
+constexpr VkDeviceSize GpuMinAllocationSize = 256;
+
+// Linear resources are buffers and linear-tiling images, NonLinear ones are optimal-tiling images.
+// The two may not share a bufferImageGranularity page.
+enum class GpuResourceTiling : uint8_t {
+    Linear,
+    NonLinear
+};
+
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // Points at offset inside the persistently mapped block, or nullptr for non host-visible memory.
+    void* mapped = nullptr;
+    uint32_t memoryType = 0;
+    uint32_t block = 0;
+};
+
+struct GpuAllocatorStatistics {
+    uint32_t blockCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize reservedBytes = 0;
+    VkDeviceSize usedBytes = 0;
+};
+
+// Called for every allocation defragment() moves. The callee copies the contents of from into to and
+// rebinds whatever resource lived in from; from is freed as soon as the callback returns.
+using GpuRelocateFn = std::function<void(const GpuAllocation& from, const GpuAllocation& to)>;
+
+// Sub-allocates buffers and images from large VkDeviceMemory blocks, one pool of blocks per memory type,
+// so the number of driver allocations stays far below maxMemoryAllocationCount. Host-visible blocks stay
+// mapped for their whole lifetime. Requests larger than half a block get a dedicated allocation.
+// Non-linear allocations are padded and aligned to bufferImageGranularity; buddy offsets are aligned to
+// their size, so such an allocation covers whole granularity pages and never shares one with a buffer.
+class GpuAllocator {
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        std::unique_ptr<BuddyAllocator> allocator;
+    };
+
+    spdlog::logger allocatorLogger;
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize bufferImageGranularity;
+    VkDeviceSize blockSize;
+    std::array<std::vector<Block>, VK_MAX_MEMORY_TYPES> pools;
+    uint32_t dedicatedAllocationCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** mapped);
+    void freeDeviceMemory(VkDeviceMemory memory, void* mapped);
+    bool allocateFromBlock(uint32_t memoryType, uint32_t block, const VkMemoryRequirements& requirements, GpuAllocation& allocation);
+
+public:
+    static constexpr uint32_t DedicatedBlock = ~0u;
+
+    GpuAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = GpuBlockSize);
+    ~GpuAllocator();
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    GpuAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, GpuResourceTiling tiling = GpuResourceTiling::Linear);
+    void free(GpuAllocation& allocation);
+
+    // Buffers used from more than one queue family list them all in queueFamilies.
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, GpuAllocation& allocation, std::span<const uint32_t> queueFamilies = {});
+    void destroyBuffer(VkBuffer buffer, GpuAllocation& allocation);
+
+    // Returns blocks without live allocations to the driver, keeping one block per memory type.
+    void releaseEmptyBlocks();
+    // Incremental compaction: for each memory type, moves the allocations of its least used block into
+    // the other blocks, then releases whatever became empty. The GPU must not be using any of the moved
+    // memory. Returns the number of allocations moved.
+    size_t defragment(const GpuRelocateFn& relocate);
+
+    GpuAllocatorStatistics getStatistics() const;
+    void logStatistics();
+};
+
+}
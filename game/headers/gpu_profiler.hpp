@@ -0,0 +1,99 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+namespace Game {
+
+// Scopes measured per frame; scopes past the limit are not timed.
+constexpr uint32_t MaxGpuScopes = 64;
+
+// Measures the GPU time of nested scopes with timestamp queries. Every frame in flight owns a range of
+// the query pool that is read back when its slot comes around again, after the slot's fence signaled,
+// so results never stall the CPU and arrive framesInFlight frames late. Per-scope averages are logged
+// once per reportInterval; with a trace path every scope is also written to a Chrome trace, viewable
+// in chrome://tracing or Perfetto. Render thread only.
+class GpuProfiler {
+private:
+    struct Scope {
+        const char* name;
+        uint32_t depth;
+    };
+
+    struct FrameScopes {
+        std::vector<Scope> scopes;
+        uint64_t frameNumber = 0;
+    };
+
+    struct ScopeStats {
+        std::string name;
+        uint32_t depth;
+        double total = 0.0;
+        double max = 0.0;
+    };
+
+    spdlog::logger profilerLogger;
+    VkDevice device;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    // Nanoseconds per timestamp tick.
+    double timestampPeriod = 0.0;
+    uint64_t timestampMask = 0;
+
+    std::vector<FrameScopes> frames;
+    uint32_t currentFrame = 0;
+    uint32_t depth = 0;
+    std::vector<uint64_t> results;
+
+    std::chrono::steady_clock::duration reportInterval;
+    std::chrono::steady_clock::time_point reportStart;
+    uint32_t reportFrames = 0;
+    // In order of first appearance, which keeps nested scopes below their parents in the log.
+    std::vector<ScopeStats> stats;
+
+    std::ofstream trace;
+    uint64_t traceBase = 0;
+    bool traceStarted = false;
+
+    void collect(uint32_t frame);
+    void report();
+    void writeTraceEvent(const Scope& scope, uint64_t frameNumber, uint64_t begin, uint64_t ticks);
+
+public:
+    static constexpr uint32_t InvalidScope = ~0u;
+
+    // queueFamily is the family the profiled command buffers are submitted to. Without timestamp
+    // support on it every scope is a no-op. An empty tracePath writes no trace.
+    GpuProfiler(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t framesInFlight,
+        const std::string& tracePath, std::chrono::milliseconds reportInterval = std::chrono::seconds(1));
+    // Collects the frames still pending, so the device must be idle.
+    ~GpuProfiler();
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Reads back frame's previous timings and resets its queries. Call right after vkBeginCommandBuffer,
+    // once the fence of frame's previous submission has signaled.
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber);
+    // name must outlive the profiler.
+    uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+    void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+};
+
+// Times the commands recorded into commandBuffer during its lifetime.
+class GpuScope {
+private:
+    GpuProfiler& profiler;
+    VkCommandBuffer commandBuffer;
+    uint32_t scope;
+
+public:
+    GpuScope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name)
+        : profiler{profiler}, commandBuffer{commandBuffer}, scope{profiler.beginScope(commandBuffer, name)} {}
+    ~GpuScope() { profiler.endScope(commandBuffer, scope); }
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "spdlog/spdlog.h"
+
+namespace Game {
+
+constexpr uint32_t MaxVertexAttributes = 8;
+
+// Everything that distinguishes one graphics pipeline from another. Viewport and scissor are always
+// dynamic. Pipelines are compatible with every render pass compatible with renderPass.
+struct GraphicsPipelineState {
+    std::string vertexShader;
+    std::string fragmentShader;
+
+    uint32_t vertexStride = 0;
+    uint32_t vertexAttributeCount = 0;
+    std::array<VkVertexInputAttributeDescription, MaxVertexAttributes> vertexAttributes{};
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkBool32 depthTest = VK_FALSE;
+    VkBool32 depthWrite = VK_FALSE;
+    VkCompareOp depthCompare = VK_COMPARE_OP_LESS;
+
+    VkBool32 blendEnable = VK_FALSE;
+    VkBlendFactor sourceColorBlend = VK_BLEND_FACTOR_ONE;
+    VkBlendFactor destinationColorBlend = VK_BLEND_FACTOR_ZERO;
+    VkBlendOp colorBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+
+    bool operator==(const GraphicsPipelineState& other) const;
+};
+
+struct GraphicsPipelineStateHash {
+    size_t operator()(const GraphicsPipelineState& state) const;
+};
+
+// Maps pipeline states to lazily created pipelines. A miss queues the state for a background compile
+// thread and returns the fallback pipeline until the real one is ready, so a new material never stalls
+// the frame that first uses it. Safe to query from any thread.
+class GraphicsPipelineCache {
+private:
+    // A state whose compile failed keeps a null pipeline and is not queued again.
+    struct Entry {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+    };
+
+    spdlog::logger pipelineLogger;
+    VkDevice device;
+    VkPipelineCache pipelineCache;
+
+    std::mutex entriesMutex;
+    std::unordered_map<GraphicsPipelineState, Entry, GraphicsPipelineStateHash> entries;
+    std::deque<GraphicsPipelineState> compileQueue;
+    std::condition_variable_any compileCondition;
+    VkPipeline fallback;
+    std::jthread compiler;
+
+    VkPipeline compile(const GraphicsPipelineState& state);
+    void compileLoop(std::stop_token stopToken);
+
+public:
+    // fallbackState is compiled before the constructor returns.
+    GraphicsPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const GraphicsPipelineState& fallbackState);
+    ~GraphicsPipelineCache();
+    GraphicsPipelineCache(const GraphicsPipelineCache&) = delete;
+    GraphicsPipelineCache& operator=(const GraphicsPipelineCache&) = delete;
+
+    // The pipeline for state if it has been compiled, otherwise the fallback pipeline.
+    VkPipeline get(const GraphicsPipelineState& state);
+    // Compiles state on the calling thread if needed. For pipelines that must exist before the first frame.
+    VkPipeline require(const GraphicsPipelineState& state);
+
+    VkPipeline getFallback() const { return fallback; }
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <span>
+#include <vector>
+#include "core/job_system.hpp"
+#include "spdlog/spdlog.h"
+
+namespace Game {
+
+// Records secondary command buffers on the job system. Every frame in flight has one command pool per
+// job thread, so threads never share a pool and a whole frame's buffers are recycled with a single
+// vkResetCommandPool per thread.
+class ParallelCommandRecorder {
+private:
+    struct ThreadPool {
+        VkCommandPool pool;
+        std::vector<VkCommandBuffer> buffers;
+        size_t used = 0;
+    };
+
+    spdlog::logger recorderLogger;
+    VkDevice device;
+    Core::JobSystem& jobSystem;
+    std::vector<std::vector<ThreadPool>> framePools;
+    std::vector<VkCommandBuffer> recorded;
+    uint32_t currentFrame = 0;
+
+    VkCommandBuffer begin(const VkCommandBufferInheritanceInfo& inheritance);
+    void end(VkCommandBuffer commandBuffer);
+
+public:
+    ParallelCommandRecorder(VkDevice device, Core::JobSystem& jobSystem, uint32_t queueFamily, uint32_t framesInFlight);
+    ~ParallelCommandRecorder();
+    ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+    ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+    // Must only be called once the fence of frame's previous submission has signaled.
+    void beginFrame(uint32_t frame);
+
+    // Calls fn(index, commandBuffer) for every index in [0, count) across the job threads, each into its
+    // own secondary command buffer begun with inheritance. Returns the buffers in index order, ready for
+    // vkCmdExecuteCommands. Only one thread may record at a time.
+    template<typename Fn>
+    std::span<const VkCommandBuffer> record(size_t count, const VkCommandBufferInheritanceInfo& inheritance, Fn&& fn) {
+        recorded.assign(count, VK_NULL_HANDLE);
+        jobSystem.parallelFor(0, count, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                VkCommandBuffer commandBuffer = begin(inheritance);
+                fn(i, commandBuffer);
+                end(commandBuffer);
+                recorded[i] = commandBuffer;
+            }
+        });
+        return recorded;
+    }
+};
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+namespace Game {
+
+constexpr const char* PipelineCachePath = "pipeline_cache.bin";
+
+// A VkPipelineCache that survives restarts. The blob is stored behind a header recording the device
+// UUID, vendor, device and driver version it was produced on, plus a checksum. A file that doesn't
+// match the running device and driver, or is damaged, is ignored and the cache starts empty.
+class PipelineCache {
+private:
+    spdlog::logger pipelineCacheLogger;
+    VkDevice device;
+    VkPhysicalDeviceProperties properties;
+    std::string path;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+
+    std::vector<char> load();
+
+public:
+    PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, std::string path = PipelineCachePath);
+    ~PipelineCache();
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    // Writes the cache next to path and renames it over path, so a crash mid-write never leaves a
+    // truncated file behind. Failures are logged rather than thrown.
+    void save();
+
+    VkPipelineCache get() const { return cache; }
+};
+
+}
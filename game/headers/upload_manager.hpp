@@ -0,0 +1,77 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <span>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "gpu_allocator.hpp"
+
+namespace Game {
+
+constexpr VkDeviceSize UploadStagingSize = 32ull * 1024 * 1024;
+
+// Streams buffer data to the GPU without stalling it. Copies are packed into a persistently mapped
+// staging ring, batched into one command buffer per flush and submitted on a dedicated transfer queue
+// when the device has one. Every batch signals a timeline semaphore value; the ring space of a batch is
+// reclaimed once the semaphore reaches it.
+class UploadManager {
+private:
+    struct Batch {
+        VkCommandBuffer commandBuffer;
+        uint64_t value;
+        VkDeviceSize consumed;
+    };
+
+    struct PendingCopy {
+        VkBuffer destination;
+        VkBufferCopy region;
+    };
+
+    spdlog::logger uploadLogger;
+    VkDevice device;
+    GpuAllocator& allocator;
+    VkQueue queue;
+    std::vector<uint32_t> queueFamilies;
+
+    VkCommandPool commandPool;
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+    VkSemaphore timeline;
+    uint64_t submittedValue = 0;
+
+    VkBuffer stagingBuffer;
+    GpuAllocation stagingMemory;
+    VkDeviceSize capacity;
+    VkDeviceSize head = 0;
+    VkDeviceSize used = 0;
+    VkDeviceSize batchConsumed = 0;
+
+    std::vector<PendingCopy> pendingCopies;
+    std::deque<Batch> inFlight;
+
+    void reclaim(bool waitForOldest);
+    VkDeviceSize allocateStaging(VkDeviceSize size);
+
+public:
+    // transferFamily may equal graphicsFamily when the device has no separate transfer queue.
+    UploadManager(VkDevice device, GpuAllocator& allocator, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily, VkDeviceSize stagingSize = UploadStagingSize);
+    ~UploadManager();
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    // Copies size bytes from data into destination at offset during the next flush. Returns the timeline
+    // value that signals once the copy has landed. Uploads larger than the ring are split.
+    uint64_t upload(VkBuffer destination, VkDeviceSize offset, const void* data, VkDeviceSize size);
+    // Submits every copy recorded since the last flush and returns the value its batch signals.
+    uint64_t flush();
+
+    bool isComplete(uint64_t value) const;
+    void wait(uint64_t value) const;
+
+    VkSemaphore getTimelineSemaphore() const { return timeline; }
+    // Value of the newest submitted batch. Graphics work waits for it before reading uploaded buffers.
+    uint64_t getSubmittedValue() const { return submittedValue; }
+    // Queue families that upload destinations must be shared between.
+    std::span<const uint32_t> getQueueFamilies() const { return queueFamilies; }
+};
+
+}
@@ -0,0 +1,74 @@
+#include "buddy_allocator.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace Game {
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t minBlockSize)
+    : minOrder{static_cast<uint32_t>(std::countr_zero(minBlockSize))},
+      maxOrder{static_cast<uint32_t>(std::countr_zero(size))},
+      freeLists(maxOrder + 1) {
+    freeLists[maxOrder].insert(0);
+}
+
+uint64_t BuddyAllocator::allocate(uint64_t size, uint64_t alignment) {
+    const uint64_t rounded = std::bit_ceil(std::max({size, alignment, uint64_t{1}}));
+    const uint32_t order = std::max(minOrder, static_cast<uint32_t>(std::countr_zero(rounded)));
+    if (order > maxOrder) {
+        return InvalidOffset;
+    }
+
+    uint32_t current = order;
+    while (current <= maxOrder && freeLists[current].empty()) {
+        current++;
+    }
+    if (current > maxOrder) {
+        return InvalidOffset;
+    }
+
+    const uint64_t offset = *freeLists[current].begin();
+    freeLists[current].erase(freeLists[current].begin());
+    // Split down to the requested order, returning the upper halves to the free lists.
+    while (current > order) {
+        current--;
+        freeLists[current].insert(offset + (1ull << current));
+    }
+
+    allocatedOrders.emplace(offset, order);
+    usedBytes += 1ull << order;
+    return offset;
+}
+
+uint64_t BuddyAllocator::free(uint64_t offset) {
+    auto it = allocatedOrders.find(offset);
+    if (it == allocatedOrders.end()) {
+        return 0;
+    }
+    uint32_t order = it->second;
+    const uint64_t released = 1ull << order;
+    allocatedOrders.erase(it);
+    usedBytes -= released;
+
+    // Merge with free buddies as far up as possible.
+    while (order < maxOrder) {
+        const uint64_t buddy = offset ^ (1ull << order);
+        if (freeLists[order].erase(buddy) == 0) {
+            break;
+        }
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    freeLists[order].insert(offset);
+    return released;
+}
+
+uint64_t BuddyAllocator::getLargestFreeBlock() const {
+    for (uint32_t order = maxOrder + 1; order-- > 0;) {
+        if (!freeLists[order].empty()) {
+            return 1ull << order;
+        }
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,213 @@
+#include "frame_capture.hpp"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "utils/utils.hpp"
+
+namespace {
+
+constexpr VkDeviceSize BytesPerPixel = 4;
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void appendChunk(std::vector<uint8_t>& out, const char (&type)[5], const std::vector<uint8_t>& data) {
+    appendBigEndian(out, static_cast<uint32_t>(data.size()));
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendBigEndian(out, crc32(out.data() + typeOffset, out.size() - typeOffset));
+}
+
+// RGBA8 PNG with unfiltered rows in stored deflate blocks. Captures are written for comparison, not
+// for size, and skipping compression keeps the writer far ahead of the frame rate.
+std::vector<uint8_t> encodePng(const uint8_t* pixels, uint32_t width, uint32_t height) {
+    const size_t rowSize = width * BytesPerPixel;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+    }
+
+    std::vector<uint8_t> zlib{0x78, 0x01};
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535) {
+        const size_t length = std::min<size_t>(65535, raw.size() - offset);
+        zlib.push_back(offset + length == raw.size() ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(length));
+        zlib.push_back(static_cast<uint8_t>(length >> 8));
+        zlib.push_back(static_cast<uint8_t>(~length));
+        zlib.push_back(static_cast<uint8_t>(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+    }
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (const uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+
+    std::vector<uint8_t> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", zlib);
+    appendChunk(png, "IEND", {});
+    return png;
+}
+
+}
+
+namespace Game {
+
+FrameCapture::FrameCapture(GpuAllocator& allocator, uint32_t framesInFlight, VkExtent2D extent, const CaptureSettings& settings)
+    : captureLogger{Utils::initLogger("FrameCapture", spdlog::level::debug)},
+      allocator{allocator},
+      extent{extent},
+      settings{settings},
+      readbacks(framesInFlight) {
+    const VkDeviceSize size = VkDeviceSize{extent.width} * extent.height * BytesPerPixel;
+    for (Readback& readback : readbacks) {
+        allocator.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback.buffer, readback.memory);
+    }
+    std::filesystem::create_directories(settings.directory);
+    writer = std::jthread([this](std::stop_token stopToken) { writeLoop(stopToken); });
+
+    captureLogger.debug("Frame Capture Initialized, every {} frames to {}", settings.interval, settings.directory);
+}
+
+FrameCapture::~FrameCapture() {
+    writer.request_stop();
+    writer.join();
+    for (Readback& readback : readbacks) {
+        allocator.destroyBuffer(readback.buffer, readback.memory);
+    }
+    captureLogger.debug("Frame Capture Shutdown after writing {} frames", writtenFrames);
+}
+
+bool FrameCapture::shouldCapture(uint64_t frameNumber) const {
+    return settings.interval > 0 && frameNumber % settings.interval == 0;
+}
+
+void FrameCapture::recordCopy(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber, VkImage image) {
+    Readback& readback = readbacks[frame];
+    VkBufferImageCopy region{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {extent.width, extent.height, 1}
+    };
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region);
+
+    // The fence makes the copy available to the device only; the host read needs its own barrier.
+    VkBufferMemoryBarrier hostBarrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = readback.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+    readback.pending = true;
+    readback.frameNumber = frameNumber;
+}
+
+void FrameCapture::collect(uint32_t frame) {
+    Readback& readback = readbacks[frame];
+    if (!readback.pending) {
+        return;
+    }
+    readback.pending = false;
+
+    const auto* mapped = static_cast<const uint8_t*>(readback.memory.mapped);
+    PendingWrite pending{
+        .frameNumber = readback.frameNumber,
+        .pixels = std::vector<uint8_t>(mapped, mapped + VkDeviceSize{extent.width} * extent.height * BytesPerPixel)
+    };
+
+    std::lock_guard lock(writeMutex);
+    writeQueue.emplace_back(std::move(pending));
+    writeCondition.notify_one();
+}
+
+// Keeps writing until the queue is empty, even after a stop request, so no captured frame is lost.
+void FrameCapture::writeLoop(std::stop_token stopToken) {
+    while (true) {
+        PendingWrite pending;
+        {
+            std::unique_lock lock(writeMutex);
+            writeCondition.wait(lock, stopToken, [this] { return !writeQueue.empty(); });
+            if (writeQueue.empty()) {
+                return;
+            }
+            pending = std::move(writeQueue.front());
+            writeQueue.pop_front();
+        }
+        write(pending);
+    }
+}
+
+void FrameCapture::write(const PendingWrite& pending) {
+    const std::filesystem::path path = std::filesystem::path(settings.directory) / (settings.format == CaptureFormat::Png
+        ? fmt::format("frame_{:06}.png", pending.frameNumber)
+        : fmt::format("frame_{:06}_{}x{}.rgba", pending.frameNumber, extent.width, extent.height));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (settings.format == CaptureFormat::Png) {
+        const std::vector<uint8_t> png = encodePng(pending.pixels.data(), extent.width, extent.height);
+        file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    } else {
+        file.write(reinterpret_cast<const char*>(pending.pixels.data()), static_cast<std::streamsize>(pending.pixels.size()));
+    }
+
+    if (!file) {
+        captureLogger.error("Failed to write {}", path.string());
+        return;
+    }
+    writtenFrames++;
+}
+
+}
@@ -0,0 +1,419 @@
+#include "frame_graph.hpp"
+#include <bit>
+#include <optional>
+#include <stdexcept>
+#include "utils/utils.hpp"
+
+namespace {
+
+using Rendering::AccessMask;
+using Rendering::ResourceAccess;
+using Rendering::TextureLayout;
+
+struct VulkanAccess {
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+};
+
+VulkanAccess vulkanAccess(ResourceAccess access) {
+    switch (access) {
+        case ResourceAccess::ColorAttachmentWrite:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT};
+        case ResourceAccess::DepthAttachmentWrite:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+        case ResourceAccess::DepthAttachmentRead:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT};
+        case ResourceAccess::VertexShaderRead:
+            return {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+        case ResourceAccess::FragmentShaderRead:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+        case ResourceAccess::ComputeShaderRead:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+        case ResourceAccess::ComputeShaderWrite:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT};
+        case ResourceAccess::IndirectRead:
+            return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT};
+        case ResourceAccess::TransferRead:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT};
+        case ResourceAccess::TransferWrite:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT};
+        // Matches the stage the acquire semaphore is waited on, so the first transition chains with it.
+        case ResourceAccess::Present:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0};
+        default:
+            return {0, 0};
+    }
+}
+
+VulkanAccess vulkanAccess(AccessMask mask) {
+    VulkanAccess result{0, 0};
+    while (mask != 0) {
+        const VulkanAccess bit = vulkanAccess(static_cast<ResourceAccess>(std::countr_zero(mask)));
+        result.stages |= bit.stages;
+        result.access |= bit.access;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+VkImageLayout vulkanLayout(TextureLayout layout) {
+    switch (layout) {
+        case TextureLayout::General: return VK_IMAGE_LAYOUT_GENERAL;
+        case TextureLayout::ColorAttachment: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        case TextureLayout::DepthAttachment: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        case TextureLayout::DepthReadOnly: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        case TextureLayout::ShaderReadOnly: return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        case TextureLayout::TransferSource: return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        case TextureLayout::TransferDestination: return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        case TextureLayout::Present: return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        default: return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+}
+
+VkImageUsageFlags imageUsage(AccessMask mask) {
+    VkImageUsageFlags usage = 0;
+    if (mask & Rendering::accessBit(ResourceAccess::ColorAttachmentWrite)) {
+        usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    }
+    if (mask & (Rendering::accessBit(ResourceAccess::DepthAttachmentWrite) | Rendering::accessBit(ResourceAccess::DepthAttachmentRead))) {
+        usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    }
+    if (mask & (Rendering::accessBit(ResourceAccess::VertexShaderRead) | Rendering::accessBit(ResourceAccess::FragmentShaderRead)
+            | Rendering::accessBit(ResourceAccess::ComputeShaderRead))) {
+        usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    }
+    if (mask & Rendering::accessBit(ResourceAccess::ComputeShaderWrite)) {
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+    if (mask & Rendering::accessBit(ResourceAccess::TransferRead)) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    if (mask & Rendering::accessBit(ResourceAccess::TransferWrite)) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+    return usage;
+}
+
+VkBufferUsageFlags bufferUsage(AccessMask mask) {
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (mask & Rendering::accessBit(ResourceAccess::IndirectRead)) {
+        usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    }
+    if (mask & Rendering::accessBit(ResourceAccess::TransferRead)) {
+        usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    }
+    if (mask & Rendering::accessBit(ResourceAccess::TransferWrite)) {
+        usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+    return usage;
+}
+
+VkImageAspectFlags aspectOf(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+}
+
+namespace Game {
+
+FrameGraph::FrameGraph(VkDevice device, GpuAllocator& allocator, uint32_t framesInFlight)
+    : frameGraphLogger{Utils::initLogger("FrameGraph", spdlog::level::debug)},
+      device{device},
+      allocator{allocator},
+      frames(framesInFlight) {
+    frameGraphLogger.debug("Frame Graph Initialized");
+}
+
+FrameGraph::~FrameGraph() {
+    for (TransientSet& set : frames) {
+        destroyTransients(set);
+    }
+    frameGraphLogger.debug("Frame Graph Shutdown");
+}
+
+void FrameGraph::beginFrame(uint32_t frame) {
+    currentFrame = frame;
+    graph.reset();
+    passCallbacks.clear();
+    physical.clear();
+}
+
+Rendering::RenderResource FrameGraph::importImage(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+    Rendering::ResourceAccess current, bool discard) {
+    physical.emplace_back(PhysicalResource{.image = image, .view = view, .aspect = aspectOf(format)});
+    return graph.importTexture(name, {extent.width, extent.height, static_cast<uint32_t>(format)}, current, discard);
+}
+
+Rendering::RenderResource FrameGraph::importBuffer(const char* name, VkBuffer buffer, VkDeviceSize size, Rendering::AccessMask current) {
+    physical.emplace_back(PhysicalResource{.buffer = buffer});
+    return graph.importBuffer(name, size, current);
+}
+
+Rendering::RenderResource FrameGraph::createImage(const char* name, VkFormat format, VkExtent2D extent) {
+    physical.emplace_back();
+    return graph.createTexture(name, {extent.width, extent.height, static_cast<uint32_t>(format)});
+}
+
+Rendering::RenderResource FrameGraph::createBuffer(const char* name, VkDeviceSize size) {
+    physical.emplace_back();
+    return graph.createBuffer(name, size);
+}
+
+void FrameGraph::markOutput(Rendering::RenderResource resource, Rendering::ResourceAccess finalAccess) {
+    graph.markOutput(resource, finalAccess);
+}
+
+Rendering::RenderPassHandle FrameGraph::addPass(const char* name, std::function<void(VkCommandBuffer)> record) {
+    passCallbacks.emplace_back(std::move(record));
+    return graph.addPass(name);
+}
+
+void FrameGraph::access(Rendering::RenderPassHandle pass, Rendering::RenderResource resource, Rendering::ResourceAccess access) {
+    graph.access(pass, resource, access);
+}
+
+void FrameGraph::setSideEffects(Rendering::RenderPassHandle pass) {
+    graph.setSideEffects(pass);
+}
+
+void FrameGraph::createTransients(TransientSet& set) {
+    set.resources.assign(set.keys.size(), PhysicalResource{});
+    set.requirements.assign(set.keys.size(), Rendering::MemoryRequirement{});
+    for (size_t i = 0; i < set.keys.size(); i++) {
+        const TransientKey& key = set.keys[i];
+        PhysicalResource& resource = set.resources[i];
+        VkMemoryRequirements requirements;
+
+        if (key.type == Rendering::RenderResourceType::Texture) {
+            const auto format = static_cast<VkFormat>(key.texture.format);
+            VkImageCreateInfo imageInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = format,
+                .extent = {key.texture.width, key.texture.height, 1},
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = imageUsage(key.usage),
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+            };
+            if (vkCreateImage(device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create transient image!");
+            }
+            resource.aspect = aspectOf(format);
+            vkGetImageMemoryRequirements(device, resource.image, &requirements);
+        } else {
+            VkBufferCreateInfo bufferInfo{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                .size = key.size,
+                .usage = bufferUsage(key.usage),
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+            };
+            if (vkCreateBuffer(device, &bufferInfo, nullptr, &resource.buffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create transient buffer!");
+            }
+            vkGetBufferMemoryRequirements(device, resource.buffer, &requirements);
+        }
+        set.requirements[i] = {requirements.size, requirements.alignment, requirements.memoryTypeBits};
+    }
+    set.slots.clear();
+    set.bound = false;
+}
+
+void FrameGraph::destroyTransients(TransientSet& set) {
+    for (PhysicalResource& resource : set.resources) {
+        if (resource.view != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, resource.view, nullptr);
+        }
+        if (resource.image != VK_NULL_HANDLE) {
+            vkDestroyImage(device, resource.image, nullptr);
+        }
+        if (resource.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, resource.buffer, nullptr);
+        }
+    }
+    for (GpuAllocation& allocation : set.memory) {
+        allocator.free(allocation);
+    }
+    set.resources.clear();
+    set.memory.clear();
+    set.bound = false;
+}
+
+// Every slot gets one allocation and all its members are bound at the start of it; the graph has
+// already made sure their lifetimes don't overlap. Slots holding an image are allocated as non-linear
+// so they never share a bufferImageGranularity page with a buffer.
+void FrameGraph::bindTransients(TransientSet& set, const std::vector<Rendering::RenderResource>& transients) {
+    std::vector<bool> holdsImage(graph.getAliasSlotCount(), false);
+    for (size_t i = 0; i < transients.size(); i++) {
+        if (set.slots[i] >= 0 && set.resources[i].image != VK_NULL_HANDLE) {
+            holdsImage[set.slots[i]] = true;
+        }
+    }
+
+    set.memory.clear();
+    for (size_t slot = 0; slot < graph.getAliasSlotCount(); slot++) {
+        const Rendering::MemoryRequirement& requirement = graph.getAliasSlotRequirement(slot);
+        const VkMemoryRequirements requirements{requirement.size, requirement.alignment, requirement.typeBits};
+        const GpuResourceTiling tiling = holdsImage[slot] ? GpuResourceTiling::NonLinear : GpuResourceTiling::Linear;
+        set.memory.emplace_back(allocator.allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, tiling));
+    }
+
+    for (size_t i = 0; i < transients.size(); i++) {
+        const int32_t slot = set.slots[i];
+        if (slot < 0) {
+            continue;
+        }
+        PhysicalResource& resource = set.resources[i];
+        const GpuAllocation& memory = set.memory[slot];
+        if (resource.image != VK_NULL_HANDLE) {
+            vkBindImageMemory(device, resource.image, memory.memory, memory.offset);
+            VkImageViewCreateInfo viewInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = resource.image,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = static_cast<VkFormat>(set.keys[i].texture.format),
+                .subresourceRange = {
+                    .aspectMask = resource.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                }
+            };
+            if (vkCreateImageView(device, &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create transient image view!");
+            }
+        } else {
+            vkBindBufferMemory(device, resource.buffer, memory.memory, memory.offset);
+        }
+    }
+    set.bound = true;
+}
+
+void FrameGraph::execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler) {
+    std::vector<Rendering::RenderResource> transients;
+    std::vector<TransientKey> keys;
+    for (Rendering::RenderResource i = 0; i < graph.getResourceCount(); i++) {
+        if (!graph.isImported(i)) {
+            transients.emplace_back(i);
+            keys.emplace_back(TransientKey{graph.getResourceType(i), graph.getTextureDesc(i), graph.getBufferSize(i), graph.getUsage(i)});
+        }
+    }
+
+    TransientSet& set = frames[currentFrame];
+    if (keys != set.keys) {
+        destroyTransients(set);
+        set.keys = std::move(keys);
+        createTransients(set);
+    }
+    for (size_t i = 0; i < transients.size(); i++) {
+        graph.setMemoryRequirement(transients[i], set.requirements[i]);
+    }
+
+    graph.compile();
+
+    std::vector<int32_t> slots;
+    for (const Rendering::RenderResource transient : transients) {
+        slots.emplace_back(graph.getAliasSlot(transient));
+    }
+    // Bound memory can't be rebound, so a new packing means new resources.
+    if (set.bound && slots != set.slots) {
+        destroyTransients(set);
+        createTransients(set);
+    }
+    if (!set.bound) {
+        set.slots = std::move(slots);
+        bindTransients(set, transients);
+        frameGraphLogger.debug("Placed {} transient resources in {} memory slots", transients.size(), graph.getAliasSlotCount());
+    }
+    for (size_t i = 0; i < transients.size(); i++) {
+        physical[transients[i]] = set.resources[i];
+    }
+
+    for (Rendering::RenderPassHandle pass = 0; pass < graph.getPassCount(); pass++) {
+        if (graph.isCulled(pass)) {
+            continue;
+        }
+        std::optional<GpuScope> scope;
+        if (profiler) {
+            scope.emplace(*profiler, commandBuffer, graph.getPassName(pass));
+        }
+        recordBarriers(commandBuffer, graph.getBarriers(pass));
+        passCallbacks[pass](commandBuffer);
+    }
+    recordBarriers(commandBuffer, graph.getFinalBarriers());
+}
+
+// All barriers of a pass go into one vkCmdPipelineBarrier.
+void FrameGraph::recordBarriers(VkCommandBuffer commandBuffer, std::span<const Rendering::ResourceBarrier> barriers) {
+    if (barriers.empty()) {
+        return;
+    }
+
+    imageBarriers.clear();
+    bufferBarriers.clear();
+    VkPipelineStageFlags sourceStages = 0;
+    VkPipelineStageFlags destinationStages = 0;
+    for (const Rendering::ResourceBarrier& barrier : barriers) {
+        const VulkanAccess before = vulkanAccess(barrier.before);
+        const VulkanAccess after = vulkanAccess(barrier.after);
+        sourceStages |= before.stages;
+        destinationStages |= after.stages;
+
+        const PhysicalResource& resource = physical[barrier.resource];
+        if (graph.getResourceType(barrier.resource) == Rendering::RenderResourceType::Texture) {
+            imageBarriers.emplace_back(VkImageMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = before.access,
+                .dstAccessMask = after.access,
+                .oldLayout = vulkanLayout(barrier.oldLayout),
+                .newLayout = vulkanLayout(barrier.newLayout),
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = resource.image,
+                .subresourceRange = {
+                    .aspectMask = resource.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .baseArrayLayer = 0,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS
+                }
+            });
+        } else {
+            bufferBarriers.emplace_back(VkBufferMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .srcAccessMask = before.access,
+                .dstAccessMask = after.access,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = resource.buffer,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE
+            });
+        }
+    }
+
+    vkCmdPipelineBarrier(commandBuffer,
+        sourceStages ? sourceStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        destinationStages ? destinationStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+}
@@ -0,0 +1,102 @@
+#include "frame_pacer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "utils/utils.hpp"
+
+namespace {
+
+constexpr auto SleepStep = std::chrono::milliseconds(1);
+// Weight of the newest sleep sample. Older samples fade out, so the estimate follows changes in timer
+// resolution or system load and stays bounded however long the game runs.
+constexpr double SleepSampleWeight = 1.0 / 64.0;
+
+}
+
+namespace Game {
+
+FramePacer::FramePacer(double frameRateLimit, std::chrono::milliseconds reportInterval)
+    : pacerLogger{Utils::initLogger("FramePacer", spdlog::level::debug)},
+      targetFrameTime{frameRateLimit > 0.0
+          ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRateLimit))
+          : Clock::duration::zero()},
+      nextFrame{Clock::now()},
+      reportInterval{reportInterval},
+      reportStart{Clock::now()} {
+    if (frameRateLimit > 0.0) {
+        pacerLogger.debug("Frame Pacer Initialized, limited to {} fps", frameRateLimit);
+    } else {
+        pacerLogger.debug("Frame Pacer Initialized, unlimited");
+    }
+}
+
+FramePacer::~FramePacer() {
+    pacerLogger.debug("Frame Pacer Shutdown");
+}
+
+void FramePacer::sleepUntil(Clock::time_point target) {
+    while (true) {
+        const double remaining = std::chrono::duration<double>(target - Clock::now()).count();
+        if (remaining <= sleepEstimate) {
+            break;
+        }
+
+        const Clock::time_point start = Clock::now();
+        std::this_thread::sleep_for(SleepStep);
+        const double observed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const double delta = observed - sleepMean;
+        sleepMean += SleepSampleWeight * delta;
+        sleepVariance = (1.0 - SleepSampleWeight) * (sleepVariance + SleepSampleWeight * delta * delta);
+        sleepEstimate = sleepMean + std::sqrt(sleepVariance);
+    }
+
+    while (Clock::now() < target) {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::waitForNextFrame(FrameTimeline& timeline) {
+    const Clock::time_point start = Clock::now();
+    if (targetFrameTime > Clock::duration::zero()) {
+        sleepUntil(nextFrame);
+        // A frame that ran long moves the schedule instead of letting the following frames catch up in
+        // a burst.
+        nextFrame = std::max(nextFrame + targetFrameTime, Clock::now());
+    }
+    timeline.mark(FrameMarker::Begin);
+    timeline.limiterWait = std::chrono::duration<double, std::milli>(timeline.markers[static_cast<size_t>(FrameMarker::Begin)] - start).count();
+}
+
+double FrameTimeline::elapsed(FrameMarker from, FrameMarker to) const {
+    return std::chrono::duration<double, std::milli>(markers[static_cast<size_t>(to)] - markers[static_cast<size_t>(from)]).count();
+}
+
+void FramePacer::endFrame(const FrameTimeline& timeline) {
+    const double inputToPresent = timeline.elapsed(FrameMarker::InputSampled, FrameMarker::Presented);
+    limiterTotal += timeline.limiterWait;
+    handoffTotal += timeline.elapsed(FrameMarker::Published, FrameMarker::Acquired);
+    fenceWaitTotal += timeline.elapsed(FrameMarker::Acquired, FrameMarker::FenceSignaled);
+    inputToPresentTotal += inputToPresent;
+    inputToPresentMax = std::max(inputToPresentMax, inputToPresent);
+    reportFrames++;
+
+    const Clock::time_point now = Clock::now();
+    if (now - reportStart < reportInterval) {
+        return;
+    }
+
+    const double seconds = std::chrono::duration<double>(now - reportStart).count();
+    pacerLogger.debug("{:.1f} fps, limiter {:.2f} ms, handoff {:.2f} ms, fence wait {:.2f} ms, input to present {:.2f} ms avg / {:.2f} ms max",
+        reportFrames / seconds, limiterTotal / reportFrames, handoffTotal / reportFrames, fenceWaitTotal / reportFrames, inputToPresentTotal / reportFrames, inputToPresentMax);
+
+    reportStart = now;
+    reportFrames = 0;
+    limiterTotal = 0.0;
+    handoffTotal = 0.0;
+    fenceWaitTotal = 0.0;
+    inputToPresentTotal = 0.0;
+    inputToPresentMax = 0.0;
+}
+
+}
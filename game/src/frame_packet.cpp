@@ -0,0 +1,59 @@
+#include "frame_packet.hpp"
+#include "utils/utils.hpp"
+
+namespace Game {
+
+FramePacketQueue::FramePacketQueue(uint32_t packetCount)
+    : queueLogger{Utils::initLogger("FramePacketQueue", spdlog::level::debug)},
+      packets(packetCount) {
+    for (FramePacket& packet : packets) {
+        freePackets.push_back(&packet);
+    }
+    queueLogger.debug("Frame Packet Queue Initialized with {} packets", packetCount);
+}
+
+FramePacketQueue::~FramePacketQueue() {
+    queueLogger.debug("Frame Packet Queue Shutdown");
+}
+
+FramePacket* FramePacketQueue::beginWrite() {
+    std::unique_lock lock(mutex);
+    condition.wait(lock, [this] { return closed || !freePackets.empty(); });
+    if (closed) {
+        return nullptr;
+    }
+    FramePacket* packet = freePackets.front();
+    freePackets.pop_front();
+    return packet;
+}
+
+void FramePacketQueue::publish(FramePacket& packet) {
+    std::lock_guard lock(mutex);
+    readyPackets.push_back(&packet);
+    condition.notify_all();
+}
+
+FramePacket* FramePacketQueue::acquire() {
+    std::unique_lock lock(mutex);
+    condition.wait(lock, [this] { return closed || !readyPackets.empty(); });
+    if (readyPackets.empty()) {
+        return nullptr;
+    }
+    FramePacket* packet = readyPackets.front();
+    readyPackets.pop_front();
+    return packet;
+}
+
+void FramePacketQueue::release(FramePacket& packet) {
+    std::lock_guard lock(mutex);
+    freePackets.push_back(&packet);
+    condition.notify_all();
+}
+
+void FramePacketQueue::close() {
+    std::lock_guard lock(mutex);
+    closed = true;
+    condition.notify_all();
+}
+
+}
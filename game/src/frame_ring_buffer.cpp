@@ -0,0 +1,56 @@
+#include "frame_ring_buffer.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include "utils/utils.hpp"
+
+namespace Game {
+
+FrameRingBuffer::FrameRingBuffer(GpuAllocator& allocator, uint32_t framesInFlight, VkDeviceSize minAlignment, VkDeviceSize frameSize)
+    : ringLogger{Utils::initLogger("FrameRingBuffer", spdlog::level::debug)},
+      allocator{allocator},
+      capacity{(framesInFlight + 1) * frameSize},
+      minAlignment{std::max<VkDeviceSize>(minAlignment, 16)},
+      frameConsumed(framesInFlight, 0) {
+    allocator.createBuffer(
+        capacity,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffer,
+        memory
+    );
+    ringLogger.debug("Frame Ring Buffer Initialized with {} MB for {} frames", capacity / (1024 * 1024), framesInFlight);
+}
+
+FrameRingBuffer::~FrameRingBuffer() {
+    allocator.destroyBuffer(buffer, memory);
+    ringLogger.debug("Frame Ring Buffer Shutdown");
+}
+
+void FrameRingBuffer::beginFrame(uint32_t frame) {
+    // Frames retire in submission order, so the slot being reused always owns the oldest bytes.
+    used -= frameConsumed[frame];
+    frameConsumed[frame] = 0;
+    currentFrame = frame;
+}
+
+FrameAllocation FrameRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    alignment = std::max(alignment, minAlignment);
+    VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+    VkDeviceSize needed = offset - head + size;
+    // Allocations never wrap; the skipped tail of the ring is charged to this frame.
+    if (offset + size > capacity) {
+        offset = 0;
+        needed = capacity - head + size;
+    }
+    if (used + needed > capacity) {
+        throw std::runtime_error("frame ring buffer out of space!");
+    }
+
+    head = offset + size;
+    used += needed;
+    frameConsumed[currentFrame] += needed;
+    return FrameAllocation{buffer, offset, static_cast<std::byte*>(memory.mapped) + offset};
+}
+
+}
@@ -4,6 +4,8 @@
 #include <thread>
 #include <iostream>
 #include <fstream>
+#include <utility>
+#include "utils/utils.hpp"
 
 namespace {
 
@@ -25,6 +27,26 @@ static std::vector<char> readFile(const std::string& filename) {
     return buffer;
 }
 
+// Gribb-Hartmann: every frustum plane is the last row of the clip matrix plus or minus another row.
+static void extractFrustumPlanes(const glm::mat4& clip, glm::vec4 (&planes)[6]) {
+    const glm::mat4 rows = glm::transpose(clip);
+    for (int axis = 0; axis < 3; axis++) {
+        planes[axis * 2] = rows[3] + rows[axis];
+        planes[axis * 2 + 1] = rows[3] - rows[axis];
+    }
+    for (glm::vec4& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+static float boundingRadius(const std::vector<Game::Vertex>& meshVertices) {
+    float radiusSquared = 0.0f;
+    for (const Game::Vertex& vertex : meshVertices) {
+        radiusSquared = std::max(radiusSquared, glm::dot(vertex.position, vertex.position));
+    }
+    return std::sqrt(radiusSquared);
+}
+
 }
 
 namespace Game {
@@ -34,51 +56,111 @@ void Game::createTextureImage() {
 }
 
 void Game::createDescriptorSets() {
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
     VkDescriptorSetAllocateInfo allocInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = descriptorPool,
-        .descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
-        .pSetLayouts = layouts.data()
+        .descriptorSetCount = 1,
+        .pSetLayouts = &descriptorSetLayout
     };
 
-    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+    if (vkAllocateDescriptorSets(device, &allocInfo, &cameraDescriptorSet) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkDescriptorBufferInfo bufferInfo {
-            .buffer = uniformBuffers[i],
-            .offset = 0,
-            .range = sizeof(UniformBufferObject)
-        };
+    // The camera data moves through the frame ring, so its offset is supplied when the set is bound.
+    VkDescriptorBufferInfo bufferInfo {
+        .buffer = frameRing->getBuffer(),
+        .offset = 0,
+        .range = sizeof(CameraUniform)
+    };
+
+    // Instances and draw batches are located through push constants, so these views span the whole ring.
+    VkDescriptorBufferInfo instanceInfo {
+        .buffer = frameRing->getBuffer(),
+        .offset = 0,
+        .range = VK_WHOLE_SIZE
+    };
+
+    VkDescriptorBufferInfo drawInfo {
+        .buffer = drawBuffer,
+        .offset = 0,
+        .range = VK_WHOLE_SIZE
+    };
+
+    VkDescriptorBufferInfo visibleInfo {
+        .buffer = visibleInstanceBuffer,
+        .offset = 0,
+        .range = VK_WHOLE_SIZE
+    };
 
-        VkWriteDescriptorSet descriptorWrite {
+    std::array<VkWriteDescriptorSet, 5> descriptorWrites{{
+        {
             .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = descriptorSets[i],
+            .dstSet = cameraDescriptorSet,
             .dstBinding = 0,
             .dstArrayElement = 0,
             .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
             .pBufferInfo = &bufferInfo
-        };
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = cameraDescriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &instanceInfo
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = cameraDescriptorSet,
+            .dstBinding = 2,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &drawInfo
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = cameraDescriptorSet,
+            .dstBinding = 3,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &visibleInfo
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = cameraDescriptorSet,
+            .dstBinding = 4,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &instanceInfo
+        }
+    }};
 
-        vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
-    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
 void Game::createDescriptorPool() {
-    VkDescriptorPoolSize poolSize{
-        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)
-    };
+    std::array<VkDescriptorPoolSize, 2> poolSizes{{
+        {
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorCount = 1
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 4
+        }
+    }};
 
     VkDescriptorPoolCreateInfo poolInfo{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
-        .poolSizeCount = 1,
-        .pPoolSizes = &poolSize
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data()
     };
 
     if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
@@ -86,49 +168,140 @@ void Game::createDescriptorPool() {
     }
 }
 
-void Game::updateUniformBuffer(uint32_t currentImage) {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+void Game::simulate(float deltaTime) {
+    simulationTime += deltaTime;
+    gameEngine.getEntityManager().setRotation(quadEntity, 0.0f, 0.0f, static_cast<float>(simulationTime) * glm::radians(90.0f));
+    gameEngine.update(deltaTime);
+}
 
-    UniformBufferObject ubo{
-        .model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+// Simulation thread. packet.windowExtent must be set and non-zero.
+void Game::extractFrame(FramePacket& packet, float interpolation) {
+    packet.camera = CameraUniform{
         .view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-        .proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float) swapChainExtent.height, 0.1f, 10.0f)
+        .proj = glm::perspective(glm::radians(45.0f), packet.windowExtent.width / (float) packet.windowExtent.height, 0.1f, 10.0f)
     };
-    ubo.proj[1][1] *= -1;
+    packet.camera.proj[1][1] *= -1;
+    extractFrustumPlanes(packet.camera.proj * packet.camera.view, packet.camera.frustumPlanes);
 
-    memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+    packet.instances.resize(std::min<size_t>(instanceBatcher->countInstances(), MaxDrawInstances));
+    packet.batches = instanceBatcher->pack(packet.instances, interpolation);
 }
 
-void Game::createUniformBuffers() {
-    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-    uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+void Game::updateCameraUniform(const FramePacket& packet) {
+    cameraOffset = static_cast<uint32_t>(frameRing->push(packet.camera).offset);
+}
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
+void Game::updateInstances(const FramePacket& packet) {
+    cullConstants = {};
+    const size_t count = packet.instances.size();
+    const std::vector<Rendering::InstanceBatch>& batches = packet.batches;
+    if (count == 0 || batches.empty()) {
+        return;
+    }
 
-        vkMapMemory(device, uniformBuffersMemory[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
+    // Aligning to the element size keeps each allocation addressable as an array of that element.
+    const FrameAllocation instances = frameRing->allocate(count * sizeof(Rendering::InstanceData), sizeof(Rendering::InstanceData));
+    std::memcpy(instances.mapped, packet.instances.data(), count * sizeof(Rendering::InstanceData));
+
+    const size_t batchCapacity = std::min<size_t>(batches.size(), MaxDrawBatches);
+    const FrameAllocation batchAllocation = frameRing->allocate(batchCapacity * sizeof(DrawBatch), sizeof(DrawBatch));
+    auto* drawBatches = static_cast<DrawBatch*>(batchAllocation.mapped);
+
+    // The quad is the only mesh so far; instances of any other mesh fall between batches and are skipped.
+    static const float quadRadius = boundingRadius(vertices);
+    uint32_t batchCount = 0;
+    for (const Rendering::InstanceBatch& batch : batches) {
+        if (batch.mesh == 0 && batchCount < batchCapacity) {
+            drawBatches[batchCount++] = DrawBatch{
+                .firstInstance = batch.firstInstance,
+                .instanceCount = batch.instanceCount,
+                .indexCount = static_cast<uint32_t>(indices.size()),
+                .firstIndex = 0,
+                .vertexOffset = 0,
+                .boundingRadius = quadRadius
+            };
+        }
     }
+
+    cullConstants = CullPushConstants{
+        .instanceBase = static_cast<uint32_t>(instances.offset / sizeof(Rendering::InstanceData)),
+        .instanceCount = static_cast<uint32_t>(count),
+        .batchBase = static_cast<uint32_t>(batchAllocation.offset / sizeof(DrawBatch)),
+        .batchCount = batchCount
+    };
+}
+
+void Game::createCullingBuffers() {
+    createBuffer(DrawBufferSize,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        drawBuffer,
+        drawBufferMemory
+    );
+
+    createBuffer(sizeof(uint32_t) * MaxDrawInstances,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        visibleInstanceBuffer,
+        visibleInstanceBufferMemory
+    );
+}
+
+void Game::createFrameRingBuffer() {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    const VkDeviceSize alignment = std::max(
+        properties.limits.minUniformBufferOffsetAlignment,
+        properties.limits.minStorageBufferOffsetAlignment
+    );
+    frameRing = std::make_unique<FrameRingBuffer>(*gpuAllocator, framesInFlight, alignment, FrameRingFrameSize);
 }
 
 void Game::createDescriptorSetLayout() {
-    VkDescriptorSetLayoutBinding uboLayoutBinding{
-        .binding = 0,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = 1,
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-        .pImmutableSamplers = nullptr
-    };
+    // Shared by the graphics and culling pipelines.
+    std::array<VkDescriptorSetLayoutBinding, 5> bindings{{
+        {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = 3,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = 4,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        }
+    }};
 
     VkDescriptorSetLayoutCreateInfo layoutInfo{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = 1,
-        .pBindings = &uboLayoutBinding
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data()
     };
 
     if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
@@ -140,36 +313,19 @@ void Game::createDescriptorSetLayout() {
 void Game::createIndexBuffer() {
     VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        bufferSize, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        stagingBuffer, 
-        stagingBufferMemory
-    );
-
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device, stagingBufferMemory);
-
-    createBuffer(bufferSize, 
+    createBuffer(bufferSize,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
         indexBuffer, 
-        indexBufferMemory
+        indexBufferMemory,
+        uploadManager->getQueueFamilies()
     );
 
-    copyBuffer(stagingBuffer, indexBuffer, bufferSize);
-
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    uploadManager->upload(indexBuffer, 0, indices.data(), bufferSize);
 }
 
 void Game::createCommandBuffers() {
-    commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    commandBuffers.resize(framesInFlight);
 
     VkCommandBufferAllocateInfo allocInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -183,119 +339,29 @@ void Game::createCommandBuffers() {
     }
 }
 
-void Game::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    VkCommandBuffer commandBuffer;
-
-    VkCommandBufferAllocateInfo allocInfo{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = commandPool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1
-    };
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-    };
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    VkBufferCopy copyRegion{
-        .size = size
-    };
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo{
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &commandBuffer
-    };
-
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-}
-
 void Game::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties, 
     VkBuffer& buffer, 
-    VkDeviceMemory& bufferMemory
+    GpuAllocation& bufferMemory,
+    std::span<const uint32_t> queueFamilies
 ) {
-    VkBufferCreateInfo bufferInfo{
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size = size,
-        .usage = usage,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE
-    };
-    
-    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create buffer!");
-    }
-
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memRequirements.size,
-        .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties)
-    };
-    
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
-
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
-}
-
-uint32_t Game::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("failed to find suitable memory type!");
+    gpuAllocator->createBuffer(size, usage, properties, buffer, bufferMemory, queueFamilies);
 }
 
 void Game::createVertexBuffer() {
     VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        bufferSize, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        stagingBuffer, 
-        stagingBufferMemory
-    );
-
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device, stagingBufferMemory);
-
     createBuffer(bufferSize,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
         vertexBuffer, 
-        vertexBufferMemory
+        vertexBufferMemory,
+        uploadManager->getQueueFamilies()
     );
 
-    copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    uploadManager->upload(vertexBuffer, 0, vertices.data(), bufferSize);
 }
 
 void Game::cleanupSwapChain() {
@@ -307,17 +373,19 @@ void Game::cleanupSwapChain() {
         vkDestroyImageView(device, imageView, nullptr);
     }
 
-    vkDestroySwapchainKHR(device, swapChain, nullptr);
+    if (settings.headless) {
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            vkDestroyImage(device, swapChainImages[i], nullptr);
+            gpuAllocator->free(offscreenImageMemory[i]);
+        }
+        offscreenImageMemory.clear();
+    } else {
+        vkDestroySwapchainKHR(device, swapChain, nullptr);
+    }
 }
 
+// Render thread. Minimized windows produce no frames, so windowExtent is never zero here.
 void Game::recreateSwapChain() {
-    int32_t width = 0;
-    int32_t height = 0;
-    SDL_Vulkan_GetDrawableSize(sdl.getWindow(), &width, &height);
-    while (width == 0 || height == 0) {
-        SDL_Vulkan_GetDrawableSize(sdl.getWindow(), &width, &height);
-        SDL_WaitEvent(nullptr);  // Wait until an event (e.g., resize) occurs
-    }
     vkDeviceWaitIdle(device);
     cleanupSwapChain();
     createSwapChain();
@@ -325,6 +393,19 @@ void Game::recreateSwapChain() {
     createFramebuffers();
 }
 
+void Game::createUploadManager() {
+    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+    const uint32_t graphicsFamily = queueFamilyIndices.graphicsFamily.value();
+
+    uploadManager = std::make_unique<UploadManager>(
+        device,
+        *gpuAllocator,
+        transferQueue,
+        queueFamilyIndices.transferFamily.value_or(graphicsFamily),
+        graphicsFamily
+    );
+}
+
 void Game::createCommandPool() {
     QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
 
@@ -347,22 +428,102 @@ void Game::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageInde
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
+    gpuProfiler->beginFrame(commandBuffer, currentFrame, frameNumber);
+
+    using Rendering::ResourceAccess;
+
+    // Offscreen targets end every frame ready to be copied out instead of presented.
+    const ResourceAccess targetAccess = settings.headless ? ResourceAccess::TransferRead : ResourceAccess::Present;
+    const Rendering::RenderResource target = frameGraph->importImage("swapchain",
+        swapChainImages[imageIndex], swapChainImageViews[imageIndex], swapChainImageFormat, swapChainExtent, targetAccess, true);
+    frameGraph->markOutput(target, targetAccess);
+    // Shared by all frames in flight; the previous frame left them being read by its draws.
+    const Rendering::RenderResource draws = frameGraph->importBuffer("draws",
+        drawBuffer, DrawBufferSize, Rendering::accessBit(ResourceAccess::IndirectRead));
+    const Rendering::RenderResource visible = frameGraph->importBuffer("visible instances",
+        visibleInstanceBuffer, sizeof(uint32_t) * MaxDrawInstances, Rendering::accessBit(ResourceAccess::VertexShaderRead));
+
+    const Rendering::RenderPassHandle clearPass = frameGraph->addPass("clear draws", [this](VkCommandBuffer cb) {
+        vkCmdFillBuffer(cb, drawBuffer, 0, DrawCountersSize, 0);
+    });
+    frameGraph->access(clearPass, draws, ResourceAccess::TransferWrite);
+
+    if (cullConstants.batchCount > 0) {
+        const Rendering::RenderPassHandle cullPass = frameGraph->addPass("cull instances", [this](VkCommandBuffer cb) {
+            vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &cameraDescriptorSet, 1, &cameraOffset);
+            vkCmdPushConstants(cb, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &cullConstants);
+            vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+            vkCmdDispatch(cb, (cullConstants.instanceCount + 63) / 64, 1, 1);
+        });
+        frameGraph->access(cullPass, draws, ResourceAccess::ComputeShaderRead);
+        frameGraph->access(cullPass, draws, ResourceAccess::ComputeShaderWrite);
+        frameGraph->access(cullPass, visible, ResourceAccess::ComputeShaderWrite);
+
+        // Descriptor set and push constants stay bound from the culling pass.
+        const Rendering::RenderPassHandle buildPass = frameGraph->addPass("build draws", [this](VkCommandBuffer cb) {
+            vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, buildDrawsPipeline);
+            vkCmdDispatch(cb, (cullConstants.batchCount + 63) / 64, 1, 1);
+        });
+        frameGraph->access(buildPass, draws, ResourceAccess::ComputeShaderRead);
+        frameGraph->access(buildPass, draws, ResourceAccess::ComputeShaderWrite);
+    }
 
-    VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-    VkRenderPassBeginInfo renderPassInfo{
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .renderPass = renderPass,
-        .framebuffer = swapChainFramebuffers[imageIndex],
-        .renderArea = {
-            .offset = {0, 0},
-            .extent = swapChainExtent
-        },
-        .clearValueCount = 1,
-        .pClearValues = &clearColor
-    };
+    const Rendering::RenderPassHandle mainPass = frameGraph->addPass("main", [this, imageIndex](VkCommandBuffer cb) {
+        VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+        VkRenderPassBeginInfo renderPassInfo{
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .renderPass = renderPass,
+            .framebuffer = swapChainFramebuffers[imageIndex],
+            .renderArea = {
+                .offset = {0, 0},
+                .extent = swapChainExtent
+            },
+            .clearValueCount = 1,
+            .pClearValues = &clearColor
+        };
+
+        vkCmdBeginRenderPass(cb, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+        const uint32_t bucketCount = (cullConstants.batchCount + DrawBucketSize - 1) / DrawBucketSize;
+        if (bucketCount > 0) {
+            VkCommandBufferInheritanceInfo inheritance{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .renderPass = renderPass,
+                .subpass = 0,
+                .framebuffer = swapChainFramebuffers[imageIndex]
+            };
+            auto secondaries = commandRecorder->record(bucketCount, inheritance, [this](size_t bucket, VkCommandBuffer secondary) {
+                recordDrawBucket(secondary, static_cast<uint32_t>(bucket));
+            });
+            vkCmdExecuteCommands(cb, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        }
+        vkCmdEndRenderPass(cb);
+    });
+    frameGraph->access(mainPass, draws, ResourceAccess::IndirectRead);
+    frameGraph->access(mainPass, visible, ResourceAccess::VertexShaderRead);
+    frameGraph->access(mainPass, target, ResourceAccess::ColorAttachmentWrite);
+
+    if (frameCapture && frameCapture->shouldCapture(frameNumber)) {
+        const Rendering::RenderPassHandle capturePass = frameGraph->addPass("capture", [this, imageIndex](VkCommandBuffer cb) {
+            frameCapture->recordCopy(cb, currentFrame, frameNumber, swapChainImages[imageIndex]);
+        });
+        frameGraph->access(capturePass, target, ResourceAccess::TransferRead);
+        frameGraph->setSideEffects(capturePass);
+    }
+
+    {
+        GpuScope frameScope(*gpuProfiler, commandBuffer, "frame");
+        frameGraph->execute(commandBuffer, gpuProfiler.get());
+    }
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+// Secondary command buffers inherit no state, so every bucket binds everything it draws with.
+void Game::recordDrawBucket(VkCommandBuffer commandBuffer, uint32_t bucket) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelines->get(meshPipelineState));
 
     VkViewport viewport{
         .x = 0.0f,
@@ -384,19 +545,22 @@ void Game::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageInde
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
     vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-    vkCmdEndRenderPass(commandBuffer);
-
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to record command buffer!");
-    }
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &cameraDescriptorSet, 1, &cameraOffset);
+
+    // Draws and their instance counts come from the culling pass; the vertex shader maps
+    // gl_InstanceIndex through the visible instance list.
+    const uint32_t firstBatch = bucket * DrawBucketSize;
+    vkCmdDrawIndexedIndirectCount(commandBuffer,
+        drawBuffer, DrawCountersSize + firstBatch * sizeof(VkDrawIndexedIndirectCommand),
+        drawBuffer, bucket * sizeof(uint32_t),
+        std::min(DrawBucketSize, cullConstants.batchCount - firstBatch),
+        sizeof(VkDrawIndexedIndirectCommand));
 }
 
 void Game::createSyncObjects() {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
 
     VkSemaphoreCreateInfo semaphoreInfo{
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
@@ -407,7 +571,7 @@ void Game::createSyncObjects() {
         .flags = VK_FENCE_CREATE_SIGNALED_BIT
     };
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (uint32_t i = 0; i < framesInFlight; i++) {
         if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
             vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
             vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
@@ -417,32 +581,61 @@ void Game::createSyncObjects() {
     }
 }
 
-void Game::drawFrame() {
+// Waits until the frame slot is free again. Called before input is sampled, so the input is no older
+// than the time it takes to record and submit the frame.
+void Game::waitForFrame(FrameTimeline& timeline) {
     vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    timeline.mark(FrameMarker::FenceSignaled);
+    if (frameCapture) {
+        frameCapture->collect(currentFrame);
+    }
+}
 
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+void Game::drawFrame(FramePacket& packet) {
+    windowExtent = packet.windowExtent;
+    framebufferResized = framebufferResized || packet.windowResized;
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapChain();
-        return;
-    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("failed to acquire swap chain image!");
+    uint32_t imageIndex = currentFrame;
+    if (!settings.headless) {
+        VkResult result = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapChain();
+            return;
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
     }
 
-    updateUniformBuffer(currentFrame);
+    frameRing->beginFrame(currentFrame);
+    commandRecorder->beginFrame(currentFrame);
+    frameGraph->beginFrame(currentFrame);
+    updateCameraUniform(packet);
+    updateInstances(packet);
 
     vkResetFences(device, 1, &inFlightFences[currentFrame]);
 
     vkResetCommandBuffer(commandBuffers[currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
     recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
 
+    // Vertex input waits for every upload submitted so far; the value is ignored for the binary semaphore.
+    // Headless frames have no image to acquire or present, so they neither wait for one nor signal.
+    const uint64_t uploadValue = uploadManager->flush();
+    const uint64_t waitValues[] = {uploadValue, 0};
+    const uint32_t waitCount = settings.headless ? 1 : 2;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = waitCount,
+        .pWaitSemaphoreValues = waitValues
+    };
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
 
-    VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    VkSemaphore waitSemaphores[] = {uploadManager->getTimelineSemaphore(), imageAvailableSemaphores[currentFrame]};
+    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    submitInfo.waitSemaphoreCount = waitCount;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
@@ -450,12 +643,21 @@ void Game::drawFrame() {
     submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
 
     VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = settings.headless ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
+    packet.timeline.mark(FrameMarker::Submitted);
+
+    frameNumber++;
+    if (settings.headless) {
+        packet.timeline.mark(FrameMarker::Presented);
+        framePacer.endFrame(packet.timeline);
+        currentFrame = (currentFrame + 1) % framesInFlight;
+        return;
+    }
 
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -469,7 +671,8 @@ void Game::drawFrame() {
 
     presentInfo.pImageIndices = &imageIndex;
 
-    result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    VkResult result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    packet.timeline.mark(FrameMarker::Presented);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
         framebufferResized = false;
@@ -478,7 +681,8 @@ void Game::drawFrame() {
         throw std::runtime_error("failed to present swap chain image!");
     }
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    framePacer.endFrame(packet.timeline);
+    currentFrame = (currentFrame + 1) % framesInFlight;
 }
 
 void Game::createFramebuffers() {
@@ -528,8 +732,9 @@ void Game::createRenderPass() {
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
         .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        // Layout transitions in and out of the pass are recorded by the frame graph.
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     };
 
     VkAttachmentReference colorAttachmentRef {
@@ -557,123 +762,75 @@ void Game::createRenderPass() {
 }
 
 void Game::createGraphicsPipeline() {
-    auto vertShaderCode = readFile("shaders/vert1.spv");
-    auto fragShaderCode = readFile("shaders/frag1.spv");
-
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
-
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        .stage = VK_SHADER_STAGE_VERTEX_BIT,
-        .module = vertShaderModule,
-        .pName = "main"
-    };
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-        .module = fragShaderModule,
-        .pName = "main"
+    VkPushConstantRange pushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(CullPushConstants)
     };
 
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &bindingDescription,
-        .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
-        .pVertexAttributeDescriptions = attributeDescriptions.data()
-    };
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        .primitiveRestartEnable = VK_FALSE
-    };
-
-    VkPipelineViewportStateCreateInfo viewportState {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .scissorCount = 1
-    };
-
-    VkPipelineRasterizationStateCreateInfo rasterizer {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .depthClampEnable = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .cullMode = VK_CULL_MODE_BACK_BIT,
-        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-        .depthBiasEnable = VK_FALSE,
-        .lineWidth = 1.0f
-    };
-
-    VkPipelineMultisampleStateCreateInfo multisampling {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-        .sampleShadingEnable = VK_FALSE
-    };
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment {
-        .blendEnable = VK_FALSE,
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
-    };
-
-    VkPipelineColorBlendStateCreateInfo colorBlending {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .logicOp = VK_LOGIC_OP_COPY,
-        .attachmentCount = 1,
-        .pAttachments = &colorBlendAttachment,
-        .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}
-    };
-
-    std::vector<VkDynamicState> dynamicStates = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-    VkPipelineDynamicStateCreateInfo dynamicState {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
-        .pDynamicStates = dynamicStates.data()
-    };
     VkPipelineLayoutCreateInfo pipelineLayoutInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .setLayoutCount = 1,
-        .pSetLayouts = &descriptorSetLayout
+        .pSetLayouts = &descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange
     };
 
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
     }
 
-    VkGraphicsPipelineCreateInfo pipelineInfo {
-        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .stageCount = 2,
-        .pStages = shaderStages,
-        .pVertexInputState = &vertexInputInfo,
-        .pInputAssemblyState = &inputAssembly,
-        .pViewportState = &viewportState,
-        .pRasterizationState = &rasterizer,
-        .pMultisampleState = &multisampling,
-        .pColorBlendState = &colorBlending,
-        .pDynamicState = &dynamicState,
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    meshPipelineState = GraphicsPipelineState{
+        .vertexShader = "shaders/vert1.spv",
+        .fragmentShader = "shaders/frag1.spv",
+        .vertexStride = Vertex::getBindingDescription().stride,
+        .vertexAttributeCount = static_cast<uint32_t>(attributeDescriptions.size()),
         .layout = pipelineLayout,
-        .renderPass = renderPass,
-        .subpass = 0,
-        .basePipelineHandle = VK_NULL_HANDLE
+        .renderPass = renderPass
     };
+    std::copy(attributeDescriptions.begin(), attributeDescriptions.end(), meshPipelineState.vertexAttributes.begin());
+
+    // The mesh pipeline doubles as the fallback for materials whose pipeline is still compiling.
+    graphicsPipelines = std::make_unique<GraphicsPipelineCache>(device, pipelineCache->get(), meshPipelineState);
+}
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
+void Game::createCullingPipelines() {
+    VkShaderModule cullShaderModule = createShaderModule(readFile("shaders/cull_instances.spv"));
+    VkShaderModule buildDrawsShaderModule = createShaderModule(readFile("shaders/build_draws.spv"));
+
+    std::array<VkComputePipelineCreateInfo, 2> pipelineInfos{{
+        {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = cullShaderModule,
+                .pName = "main"
+            },
+            .layout = pipelineLayout
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = buildDrawsShaderModule,
+                .pName = "main"
+            },
+            .layout = pipelineLayout
+        }
+    }};
+
+    std::array<VkPipeline, 2> pipelines;
+    if (vkCreateComputePipelines(device, pipelineCache->get(), static_cast<uint32_t>(pipelineInfos.size()), pipelineInfos.data(), nullptr, pipelines.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling pipelines!");
     }
+    cullPipeline = pipelines[0];
+    buildDrawsPipeline = pipelines[1];
 
-    vkDestroyShaderModule(device, fragShaderModule, nullptr);
-    vkDestroyShaderModule(device, vertShaderModule, nullptr);
+    vkDestroyShaderModule(device, buildDrawsShaderModule, nullptr);
+    vkDestroyShaderModule(device, cullShaderModule, nullptr);
 }
 
 VkResult Game::CreateDebugUtilsMessengerEXT(
@@ -725,12 +882,15 @@ bool Game::checkValidationLayerSupport() {
 }
 
 std::vector<const char*> Game::getRequiredExtensions() {
-    unsigned int extensionCount = 0;
-    if (!SDL_Vulkan_GetInstanceExtensions(sdl.getWindow(), &extensionCount, nullptr)) {
-        throw std::runtime_error("Failed to get Vulkan instance extensions from SDL!");
+    std::vector<const char*> extensions;
+    if (!settings.headless) {
+        unsigned int extensionCount = 0;
+        if (!SDL_Vulkan_GetInstanceExtensions(sdl->getWindow(), &extensionCount, nullptr)) {
+            throw std::runtime_error("Failed to get Vulkan instance extensions from SDL!");
+        }
+        extensions.resize(extensionCount);
+        SDL_Vulkan_GetInstanceExtensions(sdl->getWindow(), &extensionCount, extensions.data());
     }
-    std::vector<const char*> extensions(extensionCount);
-    SDL_Vulkan_GetInstanceExtensions(sdl.getWindow(), &extensionCount, extensions.data());
 
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -750,15 +910,24 @@ QueueFamilyIndices Game::findQueueFamilies(VkPhysicalDevice device) {
 
     int i = 0;
     for (const auto& queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        // Culling runs on the graphics queue, so its family must also support compute.
+        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !indices.graphicsFamily.has_value()) {
             indices.graphicsFamily = i;
         }
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-        if (presentSupport) {
-            indices.presentFamily = i;
+        if (settings.headless) {
+            // Nothing is presented without a surface, so the graphics queue stands in for the present queue.
+            indices.presentFamily = indices.graphicsFamily;
+        } else {
+            VkBool32 presentSupport = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            if (presentSupport && !indices.presentFamily.has_value()) {
+                indices.presentFamily = i;
+            }
         }
-        if (indices.isComplete()) {
+        if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            indices.transferFamily = i;
+        }
+        if (indices.isComplete() && indices.transferFamily.has_value()) {
             break;
         }
         i++;
@@ -768,6 +937,10 @@ QueueFamilyIndices Game::findQueueFamilies(VkPhysicalDevice device) {
 }
 
 bool Game::checkDeviceExtensionSupport(VkPhysicalDevice device) {
+    if (settings.headless) {
+        return true;
+    }
+
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
@@ -788,13 +961,23 @@ bool Game::isDeviceSuitable(VkPhysicalDevice device) {
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    bool swapChainAdequate = settings.headless;
+    if (extensionsSupported && !settings.headless) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate;
+    VkPhysicalDeviceVulkan12Features vulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+    };
+    VkPhysicalDeviceFeatures2 features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features
+    };
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    return indices.isComplete() && extensionsSupported && swapChainAdequate
+        && vulkan12Features.timelineSemaphore && vulkan12Features.drawIndirectCount && features.features.multiDrawIndirect;
 }
 
 SwapChainSupportDetails Game::querySwapChainSupport(VkPhysicalDevice device) {
@@ -823,11 +1006,7 @@ VkExtent2D Game::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
         return capabilities.currentExtent;
     } else {
-        const auto [width, height] = sdl.getWindowSize();
-        VkExtent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
+        VkExtent2D actualExtent = windowExtent;
 
         actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
         actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
@@ -838,11 +1017,15 @@ VkExtent2D Game::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
 
 VkPresentModeKHR Game::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
     for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+        if (availablePresentMode == settings.presentMode) {
             return availablePresentMode;
         }
     }
 
+    if (!presentModeFallbackLogged) {
+        gameLogger.warn("Present mode {} is not supported, falling back to FIFO", static_cast<int>(settings.presentMode));
+        presentModeFallbackLogged = true;
+    }
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -894,7 +1077,8 @@ void Game::createSwapChain() {
     VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+    // Every frame in flight may hold an image while the presentation engine holds another.
+    uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, framesInFlight + 1);
     if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
         imageCount = swapChainSupport.capabilities.maxImageCount;
     }
@@ -933,11 +1117,45 @@ void Game::createSwapChain() {
     swapChainExtent = extent;
 }
 
+// Stands in for the swapchain when headless: one image per frame in flight, so an image is free again
+// as soon as its frame's fence has signaled. RGBA so captures need no swizzle.
+void Game::createOffscreenTargets() {
+    swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    swapChainExtent = requestedExtent;
+    swapChainImages.resize(framesInFlight);
+    offscreenImageMemory.resize(framesInFlight);
+
+    for (size_t i = 0; i < swapChainImages.size(); i++) {
+        VkImageCreateInfo imageInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = swapChainImageFormat,
+            .extent = {swapChainExtent.width, swapChainExtent.height, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+        if (vkCreateImage(device, &imageInfo, nullptr, &swapChainImages[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen image!");
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, swapChainImages[i], &requirements);
+        offscreenImageMemory[i] = gpuAllocator->allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceTiling::NonLinear);
+        vkBindImageMemory(device, swapChainImages[i], offscreenImageMemory[i].memory, offscreenImageMemory[i].offset);
+    }
+}
+
 void Game::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    const uint32_t transferFamily = indices.transferFamily.value_or(indices.graphicsFamily.value());
+    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value(), transferFamily};
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -950,16 +1168,25 @@ void Game::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures deviceFeatures{};
+    VkPhysicalDeviceFeatures deviceFeatures{
+        .multiDrawIndirect = VK_TRUE
+    };
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .drawIndirectCount = VK_TRUE,
+        .timelineSemaphore = VK_TRUE
+    };
 
     VkDeviceCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &vulkan12Features,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
         .enabledLayerCount = (enableValidationLayers) ? static_cast<uint32_t>(validationLayers.size()) : 0,
         .ppEnabledLayerNames = (enableValidationLayers) ? validationLayers.data() : nullptr,
-        .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
-        .ppEnabledExtensionNames = deviceExtensions.data(),
+        .enabledExtensionCount = settings.headless ? 0 : static_cast<uint32_t>(deviceExtensions.size()),
+        .ppEnabledExtensionNames = settings.headless ? nullptr : deviceExtensions.data(),
         .pEnabledFeatures = &deviceFeatures
     };
     
@@ -969,6 +1196,7 @@ void Game::createLogicalDevice() {
 
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
 }
 
 void Game::pickPhysicalDevice() {
@@ -995,7 +1223,7 @@ void Game::pickPhysicalDevice() {
 }
 
 void Game::createSurface() {
-    if (!SDL_Vulkan_CreateSurface(sdl.getWindow(), instance, &surface)) {
+    if (!SDL_Vulkan_CreateSurface(sdl->getWindow(), instance, &surface)) {
         throw std::runtime_error("failed to create window surface!");
     }
 }
@@ -1031,7 +1259,7 @@ void Game::createInstance() {
         .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
         .pEngineName = "No Engine",
         .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-        .apiVersion = VK_API_VERSION_1_0
+        .apiVersion = VK_API_VERSION_1_2
     };
 
     auto extensions = getRequiredExtensions();
@@ -1071,20 +1299,39 @@ void Game::initWindow() {
 void Game::initVulkan() {
     createInstance();
     setupDebugMessenger();
-    createSurface();
+    if (!settings.headless) {
+        createSurface();
+    }
     pickPhysicalDevice();
     createLogicalDevice();
-    createSwapChain();
+    gpuAllocator = std::make_unique<GpuAllocator>(physicalDevice, device);
+    pipelineCache = std::make_unique<PipelineCache>(physicalDevice, device);
+    createUploadManager();
+    if (settings.headless) {
+        createOffscreenTargets();
+    } else {
+        createSwapChain();
+    }
     createImageViews();
     createRenderPass();
     createDescriptorSetLayout();
     createGraphicsPipeline();
+    createCullingPipelines();
     createFramebuffers();
     createCommandPool();
+    commandRecorder = std::make_unique<ParallelCommandRecorder>(
+        device, gameEngine.getCore().getJobSystem(), findQueueFamilies(physicalDevice).graphicsFamily.value(), framesInFlight);
+    frameGraph = std::make_unique<FrameGraph>(device, *gpuAllocator, framesInFlight);
+    gpuProfiler = std::make_unique<GpuProfiler>(device, physicalDevice, findQueueFamilies(physicalDevice).graphicsFamily.value(),
+        framesInFlight, settings.gpuTracePath);
+    if (settings.headless && settings.capture.interval > 0) {
+        frameCapture = std::make_unique<FrameCapture>(*gpuAllocator, framesInFlight, swapChainExtent, settings.capture);
+    }
     createTextureImage();
     createVertexBuffer();
     createIndexBuffer();
-    createUniformBuffers();
+    createFrameRingBuffer();
+    createCullingBuffers();
     createDescriptorPool();
     createDescriptorSets();
     createCommandBuffers();
@@ -1094,25 +1341,21 @@ void Game::initVulkan() {
 void Game::cleanup() {
     cleanupSwapChain();
 
-    vkDestroyPipeline(device, graphicsPipeline, nullptr);
+    vkDestroyPipeline(device, buildDrawsPipeline, nullptr);
+    vkDestroyPipeline(device, cullPipeline, nullptr);
+    graphicsPipelines.reset();
     vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     vkDestroyRenderPass(device, renderPass, nullptr);
     
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-        vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
-    }
-
     vkDestroyDescriptorPool(device, descriptorPool, nullptr);
     vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
-    vkDestroyBuffer(device, indexBuffer, nullptr);
-    vkFreeMemory(device, indexBufferMemory, nullptr);
+    gpuAllocator->destroyBuffer(visibleInstanceBuffer, visibleInstanceBufferMemory);
+    gpuAllocator->destroyBuffer(drawBuffer, drawBufferMemory);
+    gpuAllocator->destroyBuffer(indexBuffer, indexBufferMemory);
+    gpuAllocator->destroyBuffer(vertexBuffer, vertexBufferMemory);
 
-    vkDestroyBuffer(device, vertexBuffer, nullptr);
-    vkFreeMemory(device, vertexBufferMemory, nullptr);
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (uint32_t i = 0; i < framesInFlight; i++) {
         vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
         vkDestroyFence(device, inFlightFences[i], nullptr);
@@ -1120,6 +1363,14 @@ void Game::cleanup() {
 
     vkDestroyCommandPool(device, commandPool, nullptr);
 
+    frameCapture.reset();
+    gpuProfiler.reset();
+    frameGraph.reset();
+    commandRecorder.reset();
+    frameRing.reset();
+    uploadManager.reset();
+    gpuAllocator.reset();
+    pipelineCache.reset();
     vkDestroyDevice(device, nullptr);
 
     if (enableValidationLayers) {
@@ -1130,35 +1381,162 @@ void Game::cleanup() {
     vkDestroyInstance(instance, nullptr);
 }
 
+// Drains every pending event, then runs as many fixed simulation steps as the elapsed time allows and
+// hands the render thread one packet, blended between the last two steps by the time left over. A free
+// packet is claimed before input is polled, so the input is no older than the packets queued ahead.
 void Game::mainLoop() {
     bool running = true;
+    bool windowResized = false;
     SDL_Event event;
+    double accumulator = 0.0;
+    auto previousTime = std::chrono::steady_clock::now();
+
+    while (running) {
+        FrameTimeline timeline;
+        framePacer.waitForNextFrame(timeline);
+        FramePacket* packet = framePackets->beginWrite();
+        if (!packet) {
+            break;
+        }
 
-    while (SDL_PollEvent(&event) or running) {
-        if (event.type == SDL_QUIT) {
-            running = false;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                running = false;
+            } else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                windowResized = true;
+            }
+        }
+        timeline.mark(FrameMarker::InputSampled);
+
+        const auto currentTime = std::chrono::steady_clock::now();
+        accumulator += std::min(std::chrono::duration<double>(currentTime - previousTime).count(), MaxFrameDelta);
+        previousTime = currentTime;
+        while (accumulator >= SimulationStep) {
+            simulate(static_cast<float>(SimulationStep));
+            accumulator -= SimulationStep;
+        }
+
+        int32_t width = 0;
+        int32_t height = 0;
+        SDL_Vulkan_GetDrawableSize(sdl->getWindow(), &width, &height);
+        packet->windowExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        const bool minimized = width == 0 || height == 0;
+        if (!minimized) {
+            extractFrame(*packet, static_cast<float>(accumulator / SimulationStep));
+            packet->windowResized = std::exchange(windowResized, false);
         }
-        // if (event.type == SDL_WINDOWEVENT) { // This does nothing?
-        //     if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
-        //         int width = event.window.data1;
-        //         int height = event.window.data2;
-        //         framebufferResized = true;
-        //     }
-        // }
-        drawFrame();
+        packet->timeline = timeline;
+        packet->timeline.mark(FrameMarker::Published);
+        framePackets->publish(*packet);
+
+        if (minimized) {
+            SDL_WaitEvent(nullptr);
+        }
+    }
+}
+
+// Renders settings.frameCount frames as fast as the GPU allows and reports the throughput. Every frame
+// advances the simulation by exactly one step, so captures do not depend on how fast the frames ran.
+void Game::headlessLoop() {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t frame = 0; settings.frameCount == 0 || frame < settings.frameCount; frame++) {
+        FrameTimeline timeline;
+        framePacer.waitForNextFrame(timeline);
+        FramePacket* packet = framePackets->beginWrite();
+        if (!packet) {
+            break;
+        }
+        timeline.mark(FrameMarker::InputSampled);
+
+        simulate(static_cast<float>(SimulationStep));
+        packet->windowExtent = requestedExtent;
+        extractFrame(*packet, 1.0f);
+        packet->timeline = timeline;
+        packet->timeline.mark(FrameMarker::Published);
+        framePackets->publish(*packet);
+    }
+    stopRenderThread();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    gameLogger.info("Rendered {} frames at {}x{} in {:.3f} s: {:.1f} fps, {:.3f} ms per frame",
+        frameNumber, swapChainExtent.width, swapChainExtent.height, elapsed.count(),
+        frameNumber / elapsed.count(), elapsed.count() * 1000.0 / frameNumber);
+}
+
+void Game::startRenderThread() {
+    framePackets = std::make_unique<FramePacketQueue>(std::max(settings.framePackets, 1u));
+    renderThread = std::jthread([this] { renderLoop(); });
+}
+
+// Lets the render thread finish the packets already published, then waits for the GPU. Rethrows what
+// ended the render thread, if anything did.
+void Game::stopRenderThread() {
+    if (!renderThread.joinable()) {
+        return;
     }
+    framePackets->close();
+    renderThread.join();
     vkDeviceWaitIdle(device);
+    if (frameCapture) {
+        for (uint32_t frame = 0; frame < framesInFlight; frame++) {
+            frameCapture->collect(frame);
+        }
+    }
+    if (renderError) {
+        std::rethrow_exception(renderError);
+    }
+}
+
+void Game::renderLoop() {
+    try {
+        while (FramePacket* packet = framePackets->acquire()) {
+            packet->timeline.mark(FrameMarker::Acquired);
+            if (packet->windowExtent.width > 0 && packet->windowExtent.height > 0) {
+                waitForFrame(packet->timeline);
+                drawFrame(*packet);
+            }
+            framePackets->release(*packet);
+        }
+    } catch (...) {
+        renderError = std::current_exception();
+        framePackets->close();
+    }
 }
 
 void Game::run() {
     initWindow();
     initVulkan();
-    mainLoop();
+    startRenderThread();
+    try {
+        if (settings.headless) {
+            headlessLoop();
+        } else {
+            mainLoop();
+        }
+    } catch (...) {
+        stopRenderThread();
+        throw;
+    }
+    stopRenderThread();
     cleanup();
 }
 
-Game::Game(const uint32_t width = 1920, const uint32_t height = 1080) : sdl(width, height) {
-
+Game::Game(Engine::GameEngine& gameEngine, const uint32_t width, const uint32_t height, const GameSettings& settings)
+    : gameEngine(gameEngine),
+      gameLogger{Utils::initLogger("Game", spdlog::level::debug)},
+      settings{settings},
+      requestedExtent{width, height},
+      framePacer{settings.frameRateLimit},
+      framesInFlight{std::max(settings.framesInFlight, 1u)},
+      windowExtent{width, height} {
+    if (!settings.headless) {
+        sdl = std::make_unique<SDLWrapper::SDL>(width, height);
+    }
+    quadEntity = gameEngine.getEntityManager().addEntity();
+    gameEngine.getTransformHierarchy().addNode(quadEntity);
+    gameEngine.getComponentManager().addComponent(quadEntity, Core::WorldTransform{Engine::Mat4::identity(), Engine::Mat4::identity()});
+    gameEngine.getComponentManager().addComponent(quadEntity, Rendering::MeshInstance{.mesh = 0, .color = {1.0f, 1.0f, 1.0f, 1.0f}});
+    instanceBatcher = std::make_unique<Rendering::InstanceBatcher>(gameEngine.getComponentManager());
 }
 
 
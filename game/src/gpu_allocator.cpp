@@ -0,0 +1,292 @@
+#include "gpu_allocator.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "utils/utils.hpp"
+
+namespace Game {
+
+GpuAllocator::GpuAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize)
+    : allocatorLogger{Utils::initLogger("GpuAllocator", spdlog::level::debug)},
+      device{device},
+      blockSize{std::bit_ceil(blockSize)} {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bufferImageGranularity = properties.limits.bufferImageGranularity;
+    allocatorLogger.debug("GPU Allocator Initialized with {} MB blocks", this->blockSize / (1024 * 1024));
+}
+
+GpuAllocator::~GpuAllocator() {
+    logStatistics();
+    for (auto& pool : pools) {
+        for (Block& block : pool) {
+            if (block.memory != VK_NULL_HANDLE) {
+                freeDeviceMemory(block.memory, block.mapped);
+            }
+        }
+    }
+    allocatorLogger.debug("GPU Allocator Shutdown");
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+VkDeviceMemory GpuAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** mapped) {
+    VkMemoryAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryType
+    };
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate buffer memory!");
+    }
+
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, memory, 0, size, 0, mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, memory, nullptr);
+            throw std::runtime_error("failed to map buffer memory!");
+        }
+    }
+    return memory;
+}
+
+void GpuAllocator::freeDeviceMemory(VkDeviceMemory memory, void* mapped) {
+    if (mapped) {
+        vkUnmapMemory(device, memory);
+    }
+    vkFreeMemory(device, memory, nullptr);
+}
+
+bool GpuAllocator::allocateFromBlock(uint32_t memoryType, uint32_t blockIndex, const VkMemoryRequirements& requirements, GpuAllocation& allocation) {
+    Block& block = pools[memoryType][blockIndex];
+    if (!block.allocator) {
+        return false;
+    }
+    const uint64_t offset = block.allocator->allocate(requirements.size, requirements.alignment);
+    if (offset == BuddyAllocator::InvalidOffset) {
+        return false;
+    }
+
+    allocation = GpuAllocation{
+        .memory = block.memory,
+        .offset = offset,
+        .size = requirements.size,
+        .mapped = block.mapped ? static_cast<std::byte*>(block.mapped) + offset : nullptr,
+        .memoryType = memoryType,
+        .block = blockIndex
+    };
+    return true;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& resourceRequirements, VkMemoryPropertyFlags properties, GpuResourceTiling tiling) {
+    VkMemoryRequirements requirements = resourceRequirements;
+    if (tiling == GpuResourceTiling::NonLinear) {
+        requirements.alignment = std::max(requirements.alignment, bufferImageGranularity);
+        requirements.size = std::max(requirements.size, bufferImageGranularity);
+    }
+    const uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+
+    if (requirements.size > blockSize / 2) {
+        GpuAllocation allocation{
+            .size = requirements.size,
+            .memoryType = memoryType,
+            .block = DedicatedBlock
+        };
+        allocation.memory = allocateDeviceMemory(requirements.size, memoryType, &allocation.mapped);
+        dedicatedAllocationCount++;
+        dedicatedBytes += requirements.size;
+        return allocation;
+    }
+
+    auto& pool = pools[memoryType];
+    GpuAllocation allocation;
+    for (uint32_t block = 0; block < pool.size(); block++) {
+        if (allocateFromBlock(memoryType, block, requirements, allocation)) {
+            return allocation;
+        }
+    }
+
+    // Every block is full: reuse a released slot so block indices of live allocations stay stable.
+    auto freeSlot = std::find_if(pool.begin(), pool.end(), [](const Block& block) { return !block.allocator; });
+    const uint32_t blockIndex = static_cast<uint32_t>(freeSlot - pool.begin());
+    if (freeSlot == pool.end()) {
+        pool.emplace_back();
+    }
+    Block& block = pool[blockIndex];
+    block.memory = allocateDeviceMemory(blockSize, memoryType, &block.mapped);
+    block.allocator = std::make_unique<BuddyAllocator>(blockSize, GpuMinAllocationSize);
+    allocatorLogger.debug("Allocated {} MB block {} for memory type {}", blockSize / (1024 * 1024), blockIndex, memoryType);
+
+    if (!allocateFromBlock(memoryType, blockIndex, requirements, allocation)) {
+        throw std::runtime_error("failed to sub-allocate buffer memory!");
+    }
+    return allocation;
+}
+
+void GpuAllocator::free(GpuAllocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    if (allocation.block == DedicatedBlock) {
+        freeDeviceMemory(allocation.memory, allocation.mapped);
+        dedicatedAllocationCount--;
+        dedicatedBytes -= allocation.size;
+    } else {
+        pools[allocation.memoryType][allocation.block].allocator->free(allocation.offset);
+    }
+    allocation = GpuAllocation{};
+}
+
+void GpuAllocator::createBuffer(
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    VkBuffer& buffer,
+    GpuAllocation& allocation,
+    std::span<const uint32_t> queueFamilies
+) {
+    const bool concurrent = queueFamilies.size() > 1;
+    VkBufferCreateInfo bufferInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(queueFamilies.size()) : 0,
+        .pQueueFamilyIndices = concurrent ? queueFamilies.data() : nullptr
+    };
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+    allocation = allocate(memRequirements, properties);
+    vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+}
+
+void GpuAllocator::destroyBuffer(VkBuffer buffer, GpuAllocation& allocation) {
+    vkDestroyBuffer(device, buffer, nullptr);
+    free(allocation);
+}
+
+void GpuAllocator::releaseEmptyBlocks() {
+    for (uint32_t memoryType = 0; memoryType < memoryProperties.memoryTypeCount; memoryType++) {
+        bool keptOne = false;
+        for (Block& block : pools[memoryType]) {
+            if (!block.allocator || !block.allocator->empty()) {
+                continue;
+            }
+            if (!keptOne) {
+                keptOne = true;
+                continue;
+            }
+            freeDeviceMemory(block.memory, block.mapped);
+            block = Block{};
+        }
+    }
+}
+
+size_t GpuAllocator::defragment(const GpuRelocateFn& relocate) {
+    size_t moved = 0;
+    for (uint32_t memoryType = 0; memoryType < memoryProperties.memoryTypeCount; memoryType++) {
+        auto& pool = pools[memoryType];
+        std::vector<uint32_t> liveBlocks;
+        for (uint32_t block = 0; block < pool.size(); block++) {
+            if (pool[block].allocator && !pool[block].allocator->empty()) {
+                liveBlocks.emplace_back(block);
+            }
+        }
+        if (liveBlocks.size() < 2) {
+            continue;
+        }
+
+        // Drain the emptiest block into the fullest ones first.
+        std::sort(liveBlocks.begin(), liveBlocks.end(), [&](uint32_t a, uint32_t b) {
+            return pool[a].allocator->getUsedBytes() > pool[b].allocator->getUsedBytes();
+        });
+        const uint32_t source = liveBlocks.back();
+        liveBlocks.pop_back();
+
+        std::vector<std::pair<uint64_t, uint64_t>> allocations;
+        pool[source].allocator->forEachAllocation([&](uint64_t offset, uint64_t size) {
+            allocations.emplace_back(offset, size);
+        });
+
+        for (const auto& [offset, size] : allocations) {
+            const VkMemoryRequirements requirements{
+                .size = size,
+                .alignment = size,
+                .memoryTypeBits = 1u << memoryType
+            };
+            GpuAllocation target;
+            const bool placed = std::any_of(liveBlocks.begin(), liveBlocks.end(), [&](uint32_t block) {
+                return allocateFromBlock(memoryType, block, requirements, target);
+            });
+            if (!placed) {
+                break;
+            }
+
+            Block& block = pool[source];
+            GpuAllocation from{
+                .memory = block.memory,
+                .offset = offset,
+                .size = size,
+                .mapped = block.mapped ? static_cast<std::byte*>(block.mapped) + offset : nullptr,
+                .memoryType = memoryType,
+                .block = source
+            };
+            relocate(from, target);
+            free(from);
+            moved++;
+        }
+    }
+
+    releaseEmptyBlocks();
+    if (moved > 0) {
+        allocatorLogger.debug("Defragmentation moved {} allocations", moved);
+    }
+    return moved;
+}
+
+GpuAllocatorStatistics GpuAllocator::getStatistics() const {
+    GpuAllocatorStatistics statistics{
+        .dedicatedAllocationCount = dedicatedAllocationCount,
+        .reservedBytes = dedicatedBytes,
+        .usedBytes = dedicatedBytes
+    };
+    statistics.allocationCount = dedicatedAllocationCount;
+    for (const auto& pool : pools) {
+        for (const Block& block : pool) {
+            if (!block.allocator) {
+                continue;
+            }
+            statistics.blockCount++;
+            statistics.allocationCount += static_cast<uint32_t>(block.allocator->getAllocationCount());
+            statistics.reservedBytes += block.allocator->getSize();
+            statistics.usedBytes += block.allocator->getUsedBytes();
+        }
+    }
+    return statistics;
+}
+
+void GpuAllocator::logStatistics() {
+    const GpuAllocatorStatistics statistics = getStatistics();
+    allocatorLogger.debug("{} allocations in {} blocks and {} dedicated allocations, {} / {} KB used",
+        statistics.allocationCount, statistics.blockCount, statistics.dedicatedAllocationCount,
+        statistics.usedBytes / 1024, statistics.reservedBytes / 1024);
+}
+
+}
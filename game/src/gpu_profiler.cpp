@@ -0,0 +1,167 @@
+#include "gpu_profiler.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include "utils/utils.hpp"
+
+namespace {
+
+// Every scope takes a begin and an end timestamp.
+constexpr uint32_t QueriesPerFrame = Game::MaxGpuScopes * 2;
+
+}
+
+namespace Game {
+
+GpuProfiler::GpuProfiler(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t framesInFlight,
+    const std::string& tracePath, std::chrono::milliseconds reportInterval)
+    : profilerLogger{Utils::initLogger("GpuProfiler", spdlog::level::debug)},
+      device{device},
+      frames(framesInFlight),
+      reportInterval{reportInterval},
+      reportStart{std::chrono::steady_clock::now()} {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    const uint32_t validBits = families[queueFamily].timestampValidBits;
+    if (validBits == 0) {
+        profilerLogger.warn("Queue family {} does not support timestamps, GPU profiling is disabled", queueFamily);
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = framesInFlight * QueriesPerFrame
+    };
+    if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    if (!tracePath.empty()) {
+        trace.open(tracePath, std::ios::trunc);
+        if (!trace) {
+            throw std::runtime_error("failed to open GPU trace file!");
+        }
+        trace << R"({"traceEvents":[)" << '\n'
+              << R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"GPU"}})";
+    }
+
+    profilerLogger.debug("GPU Profiler Initialized, {} ns per tick{}", timestampPeriod,
+        tracePath.empty() ? "" : ", tracing to " + tracePath);
+}
+
+GpuProfiler::~GpuProfiler() {
+    if (queryPool != VK_NULL_HANDLE) {
+        for (uint32_t frame = 0; frame < frames.size(); frame++) {
+            collect(frame);
+        }
+        if (reportFrames > 0) {
+            report();
+        }
+        vkDestroyQueryPool(device, queryPool, nullptr);
+    }
+    if (trace.is_open()) {
+        trace << "\n]}\n";
+    }
+    profilerLogger.debug("GPU Profiler Shutdown");
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber) {
+    if (queryPool == VK_NULL_HANDLE) {
+        return;
+    }
+    collect(frame);
+    vkCmdResetQueryPool(commandBuffer, queryPool, frame * QueriesPerFrame, QueriesPerFrame);
+    frames[frame].frameNumber = frameNumber;
+    currentFrame = frame;
+    depth = 0;
+
+    if (std::chrono::steady_clock::now() - reportStart >= reportInterval && reportFrames > 0) {
+        report();
+    }
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+    std::vector<Scope>& scopes = frames[currentFrame].scopes;
+    if (queryPool == VK_NULL_HANDLE || scopes.size() >= MaxGpuScopes) {
+        return InvalidScope;
+    }
+    const uint32_t scope = static_cast<uint32_t>(scopes.size());
+    scopes.emplace_back(Scope{.name = name, .depth = depth++});
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, currentFrame * QueriesPerFrame + scope * 2);
+    return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+    if (scope == InvalidScope) {
+        return;
+    }
+    depth--;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, currentFrame * QueriesPerFrame + scope * 2 + 1);
+}
+
+// The frame's fence has signaled, so every timestamp it wrote is available without waiting. A scope
+// that was never ended leaves its query unavailable and drops the whole frame.
+void GpuProfiler::collect(uint32_t frame) {
+    FrameScopes& frameScopes = frames[frame];
+    if (frameScopes.scopes.empty()) {
+        return;
+    }
+
+    const uint32_t queryCount = static_cast<uint32_t>(frameScopes.scopes.size()) * 2;
+    results.resize(queryCount);
+    const VkResult result = vkGetQueryPoolResults(device, queryPool, frame * QueriesPerFrame, queryCount,
+        results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+        for (size_t i = 0; i < frameScopes.scopes.size(); i++) {
+            const Scope& scope = frameScopes.scopes[i];
+            const uint64_t ticks = (results[i * 2 + 1] - results[i * 2]) & timestampMask;
+            const double milliseconds = ticks * timestampPeriod / 1e6;
+
+            auto stat = std::find_if(stats.begin(), stats.end(), [&](const ScopeStats& entry) {
+                return entry.depth == scope.depth && entry.name == scope.name;
+            });
+            if (stat == stats.end()) {
+                stat = stats.insert(stats.end(), ScopeStats{.name = scope.name, .depth = scope.depth});
+            }
+            stat->total += milliseconds;
+            stat->max = std::max(stat->max, milliseconds);
+
+            if (trace.is_open()) {
+                writeTraceEvent(scope, frameScopes.frameNumber, results[i * 2], ticks);
+            }
+        }
+        reportFrames++;
+    }
+    frameScopes.scopes.clear();
+}
+
+void GpuProfiler::report() {
+    for (const ScopeStats& stat : stats) {
+        profilerLogger.debug("{:{}}{}: {:.3f} ms avg, {:.3f} ms max", "", stat.depth * 2, stat.name, stat.total / reportFrames, stat.max);
+    }
+    stats.clear();
+    reportFrames = 0;
+    reportStart = std::chrono::steady_clock::now();
+}
+
+// Scope names are string literals from the code, so they are written without JSON escaping.
+void GpuProfiler::writeTraceEvent(const Scope& scope, uint64_t frameNumber, uint64_t begin, uint64_t ticks) {
+    if (!traceStarted) {
+        traceBase = begin;
+        traceStarted = true;
+    }
+    const double start = ((begin - traceBase) & timestampMask) * timestampPeriod / 1e3;
+    const double duration = ticks * timestampPeriod / 1e3;
+    trace << fmt::format(",\n{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{}}}}}",
+        scope.name, start, duration, frameNumber);
+}
+
+}
@@ -0,0 +1,353 @@
+#include "graphics_pipeline_cache.hpp"
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "utils/utils.hpp"
+
+namespace {
+
+std::vector<char> readShader(const std::string& filename) {
+    std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open shader " + filename + "!");
+    }
+
+    std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    return buffer;
+}
+
+VkShaderModule createShaderModule(VkDevice device, const std::string& filename) {
+    const std::vector<char> code = readShader(filename);
+    VkShaderModuleCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = code.size(),
+        .pCode = reinterpret_cast<const uint32_t*>(code.data())
+    };
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+    return shaderModule;
+}
+
+// FNV-1a over the state's fields one at a time, so padding never feeds into the hash.
+class StateHasher {
+private:
+    uint64_t hash = 14695981039346656037ull;
+
+public:
+    void add(const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    template<typename T>
+    void add(const T& value) {
+        add(&value, sizeof(T));
+    }
+
+    void add(const std::string& value) {
+        add(value.data(), value.size());
+        add(value.size());
+    }
+
+    uint64_t get() const { return hash; }
+};
+
+}
+
+namespace Game {
+
+bool GraphicsPipelineState::operator==(const GraphicsPipelineState& other) const {
+    if (vertexAttributeCount != other.vertexAttributeCount) {
+        return false;
+    }
+    for (uint32_t i = 0; i < vertexAttributeCount; i++) {
+        const VkVertexInputAttributeDescription& a = vertexAttributes[i];
+        const VkVertexInputAttributeDescription& b = other.vertexAttributes[i];
+        if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset) {
+            return false;
+        }
+    }
+    return vertexShader == other.vertexShader
+        && fragmentShader == other.fragmentShader
+        && vertexStride == other.vertexStride
+        && topology == other.topology
+        && polygonMode == other.polygonMode
+        && cullMode == other.cullMode
+        && frontFace == other.frontFace
+        && depthTest == other.depthTest
+        && depthWrite == other.depthWrite
+        && depthCompare == other.depthCompare
+        && blendEnable == other.blendEnable
+        && sourceColorBlend == other.sourceColorBlend
+        && destinationColorBlend == other.destinationColorBlend
+        && colorBlendOp == other.colorBlendOp
+        && layout == other.layout
+        && renderPass == other.renderPass
+        && subpass == other.subpass;
+}
+
+size_t GraphicsPipelineStateHash::operator()(const GraphicsPipelineState& state) const {
+    StateHasher hasher;
+    hasher.add(state.vertexShader);
+    hasher.add(state.fragmentShader);
+    hasher.add(state.vertexStride);
+    hasher.add(state.vertexAttributeCount);
+    for (uint32_t i = 0; i < state.vertexAttributeCount; i++) {
+        hasher.add(state.vertexAttributes[i].location);
+        hasher.add(state.vertexAttributes[i].binding);
+        hasher.add(state.vertexAttributes[i].format);
+        hasher.add(state.vertexAttributes[i].offset);
+    }
+    hasher.add(state.topology);
+    hasher.add(state.polygonMode);
+    hasher.add(state.cullMode);
+    hasher.add(state.frontFace);
+    hasher.add(state.depthTest);
+    hasher.add(state.depthWrite);
+    hasher.add(state.depthCompare);
+    hasher.add(state.blendEnable);
+    hasher.add(state.sourceColorBlend);
+    hasher.add(state.destinationColorBlend);
+    hasher.add(state.colorBlendOp);
+    hasher.add(state.layout);
+    hasher.add(state.renderPass);
+    hasher.add(state.subpass);
+    return static_cast<size_t>(hasher.get());
+}
+
+GraphicsPipelineCache::GraphicsPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const GraphicsPipelineState& fallbackState)
+    : pipelineLogger{Utils::initLogger("GraphicsPipelineCache", spdlog::level::debug)},
+      device{device},
+      pipelineCache{pipelineCache} {
+    fallback = require(fallbackState);
+    compiler = std::jthread([this](std::stop_token stopToken) { compileLoop(stopToken); });
+    pipelineLogger.debug("Graphics Pipeline Cache Initialized");
+}
+
+// The jthread is joined first, so no compile is in flight while the pipelines are destroyed.
+GraphicsPipelineCache::~GraphicsPipelineCache() {
+    compiler.request_stop();
+    compiler.join();
+    for (auto& [state, entry] : entries) {
+        if (entry.pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, entry.pipeline, nullptr);
+        }
+    }
+    pipelineLogger.debug("Graphics Pipeline Cache Shutdown");
+}
+
+VkPipeline GraphicsPipelineCache::get(const GraphicsPipelineState& state) {
+    std::lock_guard lock(entriesMutex);
+    auto [it, inserted] = entries.try_emplace(state);
+    if (inserted) {
+        compileQueue.emplace_back(state);
+        compileCondition.notify_one();
+    }
+    return it->second.pipeline != VK_NULL_HANDLE ? it->second.pipeline : fallback;
+}
+
+VkPipeline GraphicsPipelineCache::require(const GraphicsPipelineState& state) {
+    {
+        std::lock_guard lock(entriesMutex);
+        auto it = entries.find(state);
+        if (it != entries.end() && it->second.pipeline != VK_NULL_HANDLE) {
+            return it->second.pipeline;
+        }
+    }
+
+    VkPipeline pipeline = compile(state);
+    std::lock_guard lock(entriesMutex);
+    Entry& entry = entries[state];
+    // The compile thread may have finished the same state meanwhile.
+    if (entry.pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, pipeline, nullptr);
+        return entry.pipeline;
+    }
+    entry.pipeline = pipeline;
+    return pipeline;
+}
+
+void GraphicsPipelineCache::compileLoop(std::stop_token stopToken) {
+    while (true) {
+        GraphicsPipelineState state;
+        {
+            std::unique_lock lock(entriesMutex);
+            if (!compileCondition.wait(lock, stopToken, [this] { return !compileQueue.empty(); })) {
+                return;
+            }
+            state = std::move(compileQueue.front());
+            compileQueue.pop_front();
+            if (entries[state].pipeline != VK_NULL_HANDLE) {
+                continue;
+            }
+        }
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            pipeline = compile(state);
+        } catch (const std::runtime_error& error) {
+            pipelineLogger.error("Pipeline {} + {} failed to compile, keeping the fallback: {}", state.vertexShader, state.fragmentShader, error.what());
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        if (pipeline == VK_NULL_HANDLE) {
+            continue;
+        }
+        std::lock_guard lock(entriesMutex);
+        Entry& entry = entries[state];
+        if (entry.pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        } else {
+            entry.pipeline = pipeline;
+            pipelineLogger.debug("Compiled pipeline {} + {} in {} us", state.vertexShader, state.fragmentShader, elapsed.count());
+        }
+    }
+}
+
+VkPipeline GraphicsPipelineCache::compile(const GraphicsPipelineState& state) {
+    VkShaderModule vertShaderModule = createShaderModule(device, state.vertexShader);
+    VkShaderModule fragShaderModule;
+    try {
+        fragShaderModule = createShaderModule(device, state.fragmentShader);
+    } catch (...) {
+        vkDestroyShaderModule(device, vertShaderModule, nullptr);
+        throw;
+    }
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = {
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = vertShaderModule,
+            .pName = "main"
+        },
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragShaderModule,
+            .pName = "main"
+        }
+    };
+
+    VkVertexInputBindingDescription bindingDescription{
+        .binding = 0,
+        .stride = state.vertexStride,
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+    };
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = state.vertexStride > 0 ? 1u : 0u,
+        .pVertexBindingDescriptions = &bindingDescription,
+        .vertexAttributeDescriptionCount = state.vertexAttributeCount,
+        .pVertexAttributeDescriptions = state.vertexAttributes.data()
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = state.topology,
+        .primitiveRestartEnable = VK_FALSE
+    };
+
+    VkPipelineViewportStateCreateInfo viewportState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = state.polygonMode,
+        .cullMode = state.cullMode,
+        .frontFace = state.frontFace,
+        .depthBiasEnable = VK_FALSE,
+        .lineWidth = 1.0f
+    };
+
+    VkPipelineMultisampleStateCreateInfo multisampling{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .sampleShadingEnable = VK_FALSE
+    };
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = state.depthTest,
+        .depthWriteEnable = state.depthWrite,
+        .depthCompareOp = state.depthCompare,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE
+    };
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{
+        .blendEnable = state.blendEnable,
+        .srcColorBlendFactor = state.sourceColorBlend,
+        .dstColorBlendFactor = state.destinationColorBlend,
+        .colorBlendOp = state.colorBlendOp,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+    };
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = 1,
+        .pAttachments = &colorBlendAttachment,
+        .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}
+    };
+
+    VkDynamicState dynamicStates[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = 2,
+        .pDynamicStates = dynamicStates
+    };
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .stageCount = 2,
+        .pStages = shaderStages,
+        .pVertexInputState = &vertexInputInfo,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewportState,
+        .pRasterizationState = &rasterizer,
+        .pMultisampleState = &multisampling,
+        .pDepthStencilState = &depthStencil,
+        .pColorBlendState = &colorBlending,
+        .pDynamicState = &dynamicState,
+        .layout = state.layout,
+        .renderPass = state.renderPass,
+        .subpass = state.subpass,
+        .basePipelineHandle = VK_NULL_HANDLE
+    };
+
+    VkPipeline pipeline;
+    const VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    vkDestroyShaderModule(device, fragShaderModule, nullptr);
+    vkDestroyShaderModule(device, vertShaderModule, nullptr);
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+    return pipeline;
+}
+
+}
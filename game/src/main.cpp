@@ -1,13 +1,89 @@
 #include <iostream>
+#include <stdexcept>
+#include <string_view>
 #include <spdlog/spdlog.h>
 #include "game_engine.hpp"
 #include "../headers/game.hpp"
 
-int main(int, char**){
+namespace {
+
+// --headless [--frames N] [--size WxH] [--capture-every N] [--capture-dir DIR] [--capture-format png|raw]
+// [--frames-in-flight N] [--present-mode fifo|fifo-relaxed|mailbox|immediate] [--fps-limit N] [--frame-packets N]
+// [--gpu-trace FILE]
+Game::GameSettings parseArguments(int argc, char** argv, uint32_t& width, uint32_t& height) {
+    Game::GameSettings settings;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view argument = argv[i];
+        auto value = [&]() -> std::string_view {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + std::string(argument) + "!");
+            }
+            return argv[++i];
+        };
+
+        if (argument == "--headless") {
+            settings.headless = true;
+        } else if (argument == "--frames") {
+            settings.frameCount = static_cast<uint32_t>(std::stoul(std::string(value())));
+        } else if (argument == "--size") {
+            const std::string size(value());
+            const size_t separator = size.find('x');
+            if (separator == std::string::npos) {
+                throw std::runtime_error("--size expects WIDTHxHEIGHT!");
+            }
+            width = static_cast<uint32_t>(std::stoul(size.substr(0, separator)));
+            height = static_cast<uint32_t>(std::stoul(size.substr(separator + 1)));
+        } else if (argument == "--capture-every") {
+            settings.capture.interval = static_cast<uint32_t>(std::stoul(std::string(value())));
+        } else if (argument == "--capture-dir") {
+            settings.capture.directory = value();
+        } else if (argument == "--capture-format") {
+            const std::string_view format = value();
+            if (format == "png") {
+                settings.capture.format = Game::CaptureFormat::Png;
+            } else if (format == "raw") {
+                settings.capture.format = Game::CaptureFormat::Raw;
+            } else {
+                throw std::runtime_error("--capture-format expects png or raw!");
+            }
+        } else if (argument == "--frames-in-flight") {
+            settings.framesInFlight = static_cast<uint32_t>(std::stoul(std::string(value())));
+        } else if (argument == "--present-mode") {
+            const std::string_view mode = value();
+            if (mode == "fifo") {
+                settings.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+            } else if (mode == "fifo-relaxed") {
+                settings.presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            } else if (mode == "mailbox") {
+                settings.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+            } else if (mode == "immediate") {
+                settings.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            } else {
+                throw std::runtime_error("--present-mode expects fifo, fifo-relaxed, mailbox or immediate!");
+            }
+        } else if (argument == "--fps-limit") {
+            settings.frameRateLimit = std::stod(std::string(value()));
+        } else if (argument == "--frame-packets") {
+            settings.framePackets = static_cast<uint32_t>(std::stoul(std::string(value())));
+        } else if (argument == "--gpu-trace") {
+            settings.gpuTracePath = value();
+        } else {
+            throw std::runtime_error("unknown argument " + std::string(argument) + "!");
+        }
+    }
+    return settings;
+}
+
+}
+
+int main(int argc, char** argv){
     spdlog::set_level(spdlog::level::debug);
     try {
+        uint32_t width = 1920;
+        uint32_t height = 1080;
+        const Game::GameSettings settings = parseArguments(argc, argv, width, height);
         Engine::GameEngine gameEngine;
-        Game::Game game(1920, 1080);
+        Game::Game game(gameEngine, width, height, settings);
         game.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
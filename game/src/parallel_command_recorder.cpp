@@ -0,0 +1,83 @@
+#include "parallel_command_recorder.hpp"
+#include <stdexcept>
+#include "utils/utils.hpp"
+
+namespace Game {
+
+ParallelCommandRecorder::ParallelCommandRecorder(VkDevice device, Core::JobSystem& jobSystem, uint32_t queueFamily, uint32_t framesInFlight)
+    : recorderLogger{Utils::initLogger("CommandRecorder", spdlog::level::debug)},
+      device{device},
+      jobSystem{jobSystem},
+      framePools(framesInFlight) {
+    VkCommandPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queueFamily
+    };
+
+    // One more pool than there are job threads, for outside threads that help while waiting.
+    for (auto& pools : framePools) {
+        pools.resize(jobSystem.getThreadCount() + 1);
+        for (auto& pool : pools) {
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create recording command pool!");
+            }
+        }
+    }
+    recorderLogger.debug("Command Recorder Initialized with {} pools per frame", jobSystem.getThreadCount() + 1);
+}
+
+ParallelCommandRecorder::~ParallelCommandRecorder() {
+    for (auto& pools : framePools) {
+        for (auto& pool : pools) {
+            vkDestroyCommandPool(device, pool.pool, nullptr);
+        }
+    }
+    recorderLogger.debug("Command Recorder Shutdown");
+}
+
+void ParallelCommandRecorder::beginFrame(uint32_t frame) {
+    currentFrame = frame;
+    for (auto& pool : framePools[frame]) {
+        if (pool.used > 0) {
+            vkResetCommandPool(device, pool.pool, 0);
+            pool.used = 0;
+        }
+    }
+}
+
+VkCommandBuffer ParallelCommandRecorder::begin(const VkCommandBufferInheritanceInfo& inheritance) {
+    ThreadPool& pool = framePools[currentFrame][jobSystem.getThreadIndex()];
+    if (pool.used == pool.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool.pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1
+        };
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate secondary command buffer!");
+        }
+        pool.buffers.emplace_back(commandBuffer);
+    }
+    VkCommandBuffer commandBuffer = pool.buffers[pool.used++];
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance
+    };
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording secondary command buffer!");
+    }
+    return commandBuffer;
+}
+
+void ParallelCommandRecorder::end(VkCommandBuffer commandBuffer) {
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record secondary command buffer!");
+    }
+}
+
+}
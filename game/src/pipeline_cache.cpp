@@ -0,0 +1,152 @@
+#include "pipeline_cache.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "utils/utils.hpp"
+
+namespace {
+
+constexpr uint32_t PipelineCacheMagic = 0x50434143;
+constexpr uint32_t PipelineCacheFileVersion = 1;
+
+struct PipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t fileVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t checksum;
+};
+
+// FNV-1a, enough to catch truncated or damaged files.
+uint64_t checksum(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+PipelineCacheFileHeader headerFor(const VkPhysicalDeviceProperties& properties) {
+    PipelineCacheFileHeader header{
+        .magic = PipelineCacheMagic,
+        .fileVersion = PipelineCacheFileVersion,
+        .vendorID = properties.vendorID,
+        .deviceID = properties.deviceID,
+        .driverVersion = properties.driverVersion,
+        .pipelineCacheUUID = {},
+        .dataSize = 0,
+        .checksum = 0
+    };
+    std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+}
+
+namespace Game {
+
+PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, std::string path)
+    : pipelineCacheLogger{Utils::initLogger("PipelineCache", spdlog::level::debug)},
+      device{device},
+      path{std::move(path)} {
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    const std::vector<char> data = load();
+    VkPipelineCacheCreateInfo cacheInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data()
+    };
+
+    if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+    pipelineCacheLogger.debug("Pipeline Cache Initialized with {} KB from {}", data.size() / 1024, this->path);
+}
+
+PipelineCache::~PipelineCache() {
+    save();
+    vkDestroyPipelineCache(device, cache, nullptr);
+    pipelineCacheLogger.debug("Pipeline Cache Shutdown");
+}
+
+std::vector<char> PipelineCache::load() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    PipelineCacheFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        pipelineCacheLogger.warn("Ignoring {}: truncated header", path);
+        return {};
+    }
+
+    const PipelineCacheFileHeader expected = headerFor(properties);
+    if (header.magic != expected.magic || header.fileVersion != expected.fileVersion) {
+        pipelineCacheLogger.warn("Ignoring {}: not a pipeline cache file", path);
+        return {};
+    }
+    if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID || header.driverVersion != expected.driverVersion
+            || std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        pipelineCacheLogger.info("Ignoring {}: written by a different device or driver", path);
+        return {};
+    }
+
+    std::error_code error;
+    if (header.dataSize != std::filesystem::file_size(path, error) - sizeof(header) || error) {
+        pipelineCacheLogger.warn("Ignoring {}: truncated data", path);
+        return {};
+    }
+    std::vector<char> data(header.dataSize);
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size())) || checksum(data.data(), data.size()) != header.checksum) {
+        pipelineCacheLogger.warn("Ignoring {}: corrupt data", path);
+        return {};
+    }
+    return data;
+}
+
+void PipelineCache::save() {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS) {
+        pipelineCacheLogger.warn("Failed to query pipeline cache size");
+        return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+        pipelineCacheLogger.warn("Failed to read pipeline cache");
+        return;
+    }
+    data.resize(size);
+
+    PipelineCacheFileHeader header = headerFor(properties);
+    header.dataSize = data.size();
+    header.checksum = checksum(data.data(), data.size());
+
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            pipelineCacheLogger.warn("Failed to write {}", temporaryPath);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        pipelineCacheLogger.warn("Failed to replace {}: {}", path, error.message());
+        return;
+    }
+    pipelineCacheLogger.debug("Saved {} KB to {}", data.size() / 1024, path);
+}
+
+}
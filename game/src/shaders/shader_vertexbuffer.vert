@@ -1,10 +1,24 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
+layout(binding = 0) uniform CameraUniform {
     mat4 view;
     mat4 proj;
-} ubo;
+} camera;
+
+// Rows of the affine model matrix, matching Rendering::InstanceData.
+struct Instance {
+    vec4 modelRows[3];
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+// Written by the culling pass: ring indices of the visible instances, grouped by draw.
+layout(std430, binding = 3) readonly buffer VisibleInstanceBuffer {
+    uint visibleInstances[];
+};
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -12,6 +26,8 @@ layout(location = 1) in vec3 inColor;
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
-}
\ No newline at end of file
+    Instance instance = instances[visibleInstances[gl_InstanceIndex]];
+    vec3 world = vec4(inPosition, 0.0, 1.0) * mat3x4(instance.modelRows[0], instance.modelRows[1], instance.modelRows[2]);
+    gl_Position = camera.proj * camera.view * vec4(world, 1.0);
+    fragColor = inColor * instance.color.rgb;
+}
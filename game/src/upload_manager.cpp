@@ -0,0 +1,227 @@
+#include "upload_manager.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "utils/utils.hpp"
+
+namespace {
+
+constexpr VkDeviceSize StagingAlignment = 16;
+
+}
+
+namespace Game {
+
+UploadManager::UploadManager(
+    VkDevice device,
+    GpuAllocator& allocator,
+    VkQueue transferQueue,
+    uint32_t transferFamily,
+    uint32_t graphicsFamily,
+    VkDeviceSize stagingSize
+)
+    : uploadLogger{Utils::initLogger("UploadManager", spdlog::level::debug)},
+      device{device},
+      allocator{allocator},
+      queue{transferQueue},
+      capacity{stagingSize} {
+    queueFamilies.emplace_back(graphicsFamily);
+    if (transferFamily != graphicsFamily) {
+        queueFamilies.emplace_back(transferFamily);
+    }
+
+    VkCommandPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = transferFamily
+    };
+
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    VkSemaphoreTypeCreateInfo timelineInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0
+    };
+
+    VkSemaphoreCreateInfo semaphoreInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timelineInfo
+    };
+
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload timeline semaphore!");
+    }
+
+    allocator.createBuffer(
+        capacity,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer,
+        stagingMemory
+    );
+
+    uploadLogger.debug("Upload Manager Initialized on {} queue with {} MB staging ring",
+        transferFamily != graphicsFamily ? "dedicated transfer" : "graphics", capacity / (1024 * 1024));
+}
+
+UploadManager::~UploadManager() {
+    flush();
+    wait(submittedValue);
+    allocator.destroyBuffer(stagingBuffer, stagingMemory);
+    vkDestroySemaphore(device, timeline, nullptr);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    uploadLogger.debug("Upload Manager Shutdown");
+}
+
+void UploadManager::reclaim(bool waitForOldest) {
+    if (waitForOldest && !inFlight.empty()) {
+        wait(inFlight.front().value);
+    }
+
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device, timeline, &completed);
+    while (!inFlight.empty() && inFlight.front().value <= completed) {
+        used -= inFlight.front().consumed;
+        freeCommandBuffers.emplace_back(inFlight.front().commandBuffer);
+        inFlight.pop_front();
+    }
+}
+
+VkDeviceSize UploadManager::allocateStaging(VkDeviceSize size) {
+    while (true) {
+        VkDeviceSize offset = (head + StagingAlignment - 1) & ~(StagingAlignment - 1);
+        VkDeviceSize needed = offset - head + size;
+        // Never split a copy across the end of the ring; skip the tail and start over at zero.
+        if (offset + size > capacity) {
+            offset = 0;
+            needed = capacity - head + size;
+        }
+
+        if (used + needed <= capacity) {
+            head = offset + size;
+            used += needed;
+            batchConsumed += needed;
+            return offset;
+        }
+
+        // Out of ring space: our own pending copies may be what holds it, so submit them first.
+        if (!pendingCopies.empty()) {
+            flush();
+        }
+        reclaim(true);
+    }
+}
+
+uint64_t UploadManager::upload(VkBuffer destination, VkDeviceSize offset, const void* data, VkDeviceSize size) {
+    const VkDeviceSize maxPiece = capacity / 4;
+    const auto* source = static_cast<const std::byte*>(data);
+    for (VkDeviceSize copied = 0; copied < size;) {
+        const VkDeviceSize piece = std::min(maxPiece, size - copied);
+        const VkDeviceSize stagingOffset = allocateStaging(piece);
+        std::memcpy(static_cast<std::byte*>(stagingMemory.mapped) + stagingOffset, source + copied, piece);
+        pendingCopies.emplace_back(PendingCopy{destination, VkBufferCopy{
+            .srcOffset = stagingOffset,
+            .dstOffset = offset + copied,
+            .size = piece
+        }});
+        copied += piece;
+    }
+    return submittedValue + 1;
+}
+
+uint64_t UploadManager::flush() {
+    if (pendingCopies.empty()) {
+        return submittedValue;
+    }
+    reclaim(false);
+
+    VkCommandBuffer commandBuffer;
+    if (!freeCommandBuffers.empty()) {
+        commandBuffer = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+        vkResetCommandBuffer(commandBuffer, 0);
+    } else {
+        VkCommandBufferAllocateInfo allocInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+        if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+    }
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    // Copies are sorted by destination so consecutive regions of one buffer go out in a single command.
+    std::stable_sort(pendingCopies.begin(), pendingCopies.end(), [](const PendingCopy& a, const PendingCopy& b) {
+        return a.destination < b.destination;
+    });
+    std::vector<VkBufferCopy> regions;
+    for (size_t begin = 0; begin < pendingCopies.size();) {
+        size_t end = begin;
+        regions.clear();
+        while (end < pendingCopies.size() && pendingCopies[end].destination == pendingCopies[begin].destination) {
+            regions.emplace_back(pendingCopies[end].region);
+            end++;
+        }
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, pendingCopies[begin].destination, static_cast<uint32_t>(regions.size()), regions.data());
+        begin = end;
+    }
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record upload command buffer!");
+    }
+
+    const uint64_t signalValue = submittedValue + 1;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &signalValue
+    };
+
+    VkSubmitInfo submitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &timelineInfo,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &commandBuffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &timeline
+    };
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit upload command buffer!");
+    }
+
+    submittedValue = signalValue;
+    inFlight.emplace_back(Batch{commandBuffer, signalValue, batchConsumed});
+    batchConsumed = 0;
+    pendingCopies.clear();
+    return signalValue;
+}
+
+bool UploadManager::isComplete(uint64_t value) const {
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device, timeline, &completed);
+    return completed >= value;
+}
+
+void UploadManager::wait(uint64_t value) const {
+    VkSemaphoreWaitInfo waitInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &timeline,
+        .pValues = &value
+    };
+    vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+}
+
+}
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "core/entity_manager.hpp"
+
+namespace {
+
+// Array-of-structures layout the SoA streams replace, used as the scalar baseline.
+struct EntityAoS {
+    float positionX, positionY, positionZ;
+    float velocityX, velocityY, velocityZ;
+    float accelerationX, accelerationY, accelerationZ;
+    float rotationX, rotationY, rotationZ;
+};
+
+template<typename Fn>
+double bestOfMilliseconds(int iterations, Fn&& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const size_t entityCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 50;
+    const float deltaTime = 1.0f / 60.0f;
+
+    std::vector<EntityAoS> aos(entityCount);
+    for (size_t i = 0; i < entityCount; i++) {
+        aos[i] = EntityAoS{
+            .positionX = float(i), .positionY = 0.0f, .positionZ = 0.0f,
+            .velocityX = 1.0f, .velocityY = 2.0f, .velocityZ = 3.0f,
+            .accelerationX = 0.0f, .accelerationY = -9.81f, .accelerationZ = 0.0f,
+            .rotationX = 0.0f, .rotationY = 0.0f, .rotationZ = 0.0f
+        };
+    }
+
+    Core::EntityManager entityManager;
+    entityManager.reserve(entityCount);
+    for (size_t i = 0; i < entityCount; i++) {
+        const Core::Entity entity = entityManager.addEntity();
+        entityManager.setPosition(entity, float(i), 0.0f, 0.0f);
+        entityManager.setVelocity(entity, 1.0f, 2.0f, 3.0f);
+        entityManager.setAcceleration(entity, 0.0f, -9.81f, 0.0f);
+    }
+
+    const double aosMs = bestOfMilliseconds(iterations, [&] {
+        for (auto& entity : aos) {
+            entity.velocityX += entity.accelerationX * deltaTime;
+            entity.velocityY += entity.accelerationY * deltaTime;
+            entity.velocityZ += entity.accelerationZ * deltaTime;
+            entity.positionX += entity.velocityX * deltaTime;
+            entity.positionY += entity.velocityY * deltaTime;
+            entity.positionZ += entity.velocityZ * deltaTime;
+        }
+    });
+
+    const double soaMs = bestOfMilliseconds(iterations, [&] {
+        entityManager.updateEntities(deltaTime);
+    });
+
+    // Keep the baseline loop observable so it is not optimised away.
+    float checksum = 0.0f;
+    for (size_t i = 0; i < entityCount; i += 4096) {
+        checksum += aos[i].positionY + entityManager.getPositionY()[i];
+    }
+
+    spdlog::info("{} entities, best of {} iterations (checksum {})", entityCount, iterations, checksum);
+    spdlog::info("  scalar AoS:     {:.3f} ms", aosMs);
+    spdlog::info("  SoA integrator: {:.3f} ms ({:.2f}x)", soaMs, aosMs / soaMs);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#include "core/entity_manager.hpp"
+#include "core/memory_arena.hpp"
+
+namespace Core {
+
+constexpr size_t MaxComponents = 64;
+constexpr size_t ChunkSize = 16 * 1024;
+constexpr size_t ChunkColumnAlignment = 64;
+
+using ComponentTypeID = uint32_t;
+using ComponentMask = std::bitset<MaxComponents>;
+
+struct ComponentInfo {
+    size_t size;
+    size_t alignment;
+    const char* name;
+};
+
+ComponentTypeID registerComponentType(size_t size, size_t alignment, const char* name);
+const ComponentInfo& getComponentInfo(ComponentTypeID type);
+
+// Components are moved between chunks with memcpy, so they must be trivially copyable.
+template<typename Component>
+ComponentTypeID registeredComponentTypeID() {
+    static_assert(std::is_trivially_copyable_v<Component>, "components must be trivially copyable");
+    static const ComponentTypeID id = registerComponentType(sizeof(Component), alignof(Component), typeid(Component).name());
+    return id;
+}
+
+// Const and non-const views of a component share one id.
+template<typename T>
+ComponentTypeID componentTypeID() {
+    return registeredComponentTypeID<std::remove_cv_t<T>>();
+}
+
+template<typename... Ts>
+ComponentMask componentMask() {
+    ComponentMask mask;
+    (mask.set(componentTypeID<Ts>()), ...);
+    return mask;
+}
+
+// 64 bits so the counter can't wrap within any realistic session.
+using ChangeVersion = uint64_t;
+
+// A fixed-size block of SoA columns. Column 0 always holds the owning entities.
+// versions[column] is the change version of the last mutable access to that column.
+struct Chunk {
+    std::byte* data;
+    uint32_t count;
+    std::vector<ChangeVersion> versions;
+};
+
+class Archetype {
+private:
+    ComponentMask mask;
+    std::vector<ComponentTypeID> types;
+    std::array<int32_t, MaxComponents> columnOf;
+    std::vector<size_t> columnOffsets;
+    std::vector<size_t> columnSizes;
+    size_t entityColumnOffset = 0;
+    uint32_t chunkCapacity = 0;
+    uint32_t entityCount = 0;
+    std::vector<Chunk> chunks;
+    BlockPool& chunkPool;
+
+    std::array<Archetype*, MaxComponents> addEdges{};
+    std::array<Archetype*, MaxComponents> removeEdges{};
+
+    friend class ComponentManager;
+
+    Chunk& allocateChunk(ChangeVersion version);
+    void markChanged(Chunk& chunk, ChangeVersion version);
+
+public:
+    // Chunk memory comes from chunkPool and goes back to it when the archetype shrinks or is destroyed.
+    Archetype(const ComponentMask& mask, BlockPool& chunkPool);
+    ~Archetype();
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    // Structural changes stamp every column of the chunks they touch with version.
+    // Appends a row for entity and returns its slot. Component data is zero initialised.
+    uint32_t addRow(Entity entity, ChangeVersion version);
+    // Appends one contiguous run of rows and returns the slot of the first.
+    uint32_t addRows(std::span<const Entity> entities, ChangeVersion version);
+    // Removes the row at slot by moving the last row into it. Returns the entity that moved, or NullEntity.
+    Entity removeRow(uint32_t slot, ChangeVersion version);
+
+    void* getComponent(ComponentTypeID type, uint32_t slot);
+    void markColumnChanged(ComponentTypeID type, uint32_t slot, ChangeVersion version);
+    Entity getEntity(uint32_t slot) const;
+
+    const ComponentMask& getMask() const { return mask; }
+    const std::vector<ComponentTypeID>& getTypes() const { return types; }
+    const std::vector<Chunk>& getChunks() const { return chunks; }
+    std::vector<Chunk>& getChunks() { return chunks; }
+    uint32_t getChunkCapacity() const { return chunkCapacity; }
+    uint32_t size() const { return entityCount; }
+    bool hasComponent(ComponentTypeID type) const { return columnOf[type] >= 0; }
+    int32_t getColumn(ComponentTypeID type) const { return columnOf[type]; }
+    size_t getColumnOffset(ComponentTypeID type) const { return columnOffsets[columnOf[type]]; }
+
+    template<typename T>
+    T* getColumn(const Chunk& chunk) const {
+        return reinterpret_cast<T*>(chunk.data + columnOffsets[columnOf[componentTypeID<T>()]]);
+    }
+
+    Entity* getEntities(const Chunk& chunk) const {
+        return reinterpret_cast<Entity*>(chunk.data + entityColumnOffset);
+    }
+
+    std::byte* getColumnData(const Chunk& chunk, int32_t column) const {
+        return chunk.data + columnOffsets[column];
+    }
+};
+
+}
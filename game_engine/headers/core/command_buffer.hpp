@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "core/component_manager.hpp"
+#include "core/entity_manager.hpp"
+#include "core/memory_arena.hpp"
+
+namespace Core {
+
+// Entities created through a command buffer carry this bit until playback assigns them a real handle.
+constexpr uint32_t PendingEntityBit = 1u << 31;
+
+enum class EntityCommandType : uint8_t {
+    Create,
+    Destroy,
+    AddComponent,
+    RemoveComponent
+};
+
+struct EntityCommand {
+    EntityCommandType type;
+    ComponentTypeID component;
+    Entity entity;
+    uint32_t payloadOffset;
+};
+
+// Records structural changes for later playback. Each buffer belongs to a single thread.
+class EntityCommandBuffer {
+private:
+    std::vector<EntityCommand> commands;
+    std::vector<std::byte> payload;
+    uint32_t pendingEntities = 0;
+    uint32_t bufferIndex;
+
+    friend class EntityCommandQueue;
+
+public:
+    explicit EntityCommandBuffer(uint32_t bufferIndex) : bufferIndex{bufferIndex} {}
+
+    // The returned handle is only valid for commands recorded into this same buffer.
+    Entity createEntity();
+    void destroyEntity(Entity entity);
+    void removeComponent(Entity entity, ComponentTypeID type);
+    void addComponent(Entity entity, ComponentTypeID type, const void* value, size_t size);
+
+    template<typename T>
+    void addComponent(Entity entity, const T& value = T{}) {
+        addComponent(entity, componentTypeID<T>(), &value, sizeof(T));
+    }
+
+    template<typename T>
+    void removeComponent(Entity entity) {
+        removeComponent(entity, componentTypeID<T>());
+    }
+
+    bool empty() const { return commands.empty(); }
+    void clear();
+};
+
+// Hands every thread its own EntityCommandBuffer and applies them all at a sync point.
+class EntityCommandQueue {
+private:
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<EntityCommandBuffer>> buffers;
+    const uint64_t queueID;
+
+public:
+    EntityCommandQueue();
+
+    EntityCommandBuffer& local();
+    // Must run while no system is recording. Folds every buffer into one net change per entity and
+    // moves entities between archetypes in batches. Temporary command lists come from scratch and are
+    // released when the call returns.
+    void playback(EntityManager& entityManager, ComponentManager& componentManager, MemoryArena& scratch);
+};
+
+}
@@ -1,16 +1,115 @@
 #pragma once
+#include <atomic>
 #include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "spdlog/spdlog.h"
+#include "core/archetype.hpp"
 
 namespace Core {
 
+struct EntityLocation {
+    Archetype* archetype = nullptr;
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+};
+
 class ComponentManager {
 private:
+    struct QueryCache {
+        std::vector<Archetype*> archetypes;
+        size_t archetypesSeen = 0;
+    };
+
     spdlog::logger componentLogger;
+    // Level lifetime: every chunk lives in this arena until clear() drops the whole level at once.
+    MemoryArena levelArena;
+    BlockPool chunkPool;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype*> archetypeByMask;
+    std::unordered_map<ComponentMask, QueryCache> queryCaches;
+    // Indexed by Entity::id, so locating an entity's row never hashes.
+    std::vector<EntityLocation> locations;
+    std::atomic<ChangeVersion> changeVersion{0};
+    uint32_t levelGeneration = 0;
+
+    EntityLocation* findLocation(Entity entity);
+    void moveEntity(Entity entity, EntityLocation& location, Archetype* target, ChangeVersion version);
 
 public:
     ComponentManager();
     ~ComponentManager();
+
+    void* addComponent(Entity entity, ComponentTypeID type);
+    void removeComponent(Entity entity, ComponentTypeID type);
+    // Mutable access stamps the component's chunk column as changed; the const overload does not.
+    void* getComponent(Entity entity, ComponentTypeID type);
+    const void* getComponent(Entity entity, ComponentTypeID type) const;
+    bool hasComponent(Entity entity, ComponentTypeID type) const;
+    void removeEntity(Entity entity);
+    // Destroys every archetype and component at once and rewinds the level arena. Archetype pointers
+    // from before the call are invalid; views notice through getLevelGeneration().
+    void clear();
+    uint32_t getLevelGeneration() const { return levelGeneration; }
+    const MemoryArena& getLevelArena() const { return levelArena; }
+
+    // Change versions are 64-bit and never wrap. Only a view pass takes a fresh one, so the counter
+    // advances a handful of times per system per frame. Random access and structural changes stamp
+    // the pending version, one above the last issued: it is newer than every pass taken so far, so a
+    // reader that remembers the version of its previous pass sees exactly the chunks written since.
+    ChangeVersion nextChangeVersion() { return changeVersion.fetch_add(1, std::memory_order_relaxed) + 1; }
+    ChangeVersion getChangeVersion() const { return changeVersion.load(std::memory_order_relaxed); }
+    ChangeVersion getWriteVersion() const { return getChangeVersion() + 1; }
+
+    Archetype* getOrCreateArchetype(const ComponentMask& mask);
+    const EntityLocation* getLocation(Entity entity) const;
+    // Moves every entity, all currently stored in source (or nowhere, for source == nullptr), to the
+    // archetype for targetMask. Rows are copied in runs, so moving whole chunks costs one memcpy per column.
+    void moveEntities(Archetype* source, const ComponentMask& targetMask, std::span<const Entity> entities);
+
+    // Archetypes containing every component in required. Results are cached per mask.
+    const std::vector<Archetype*>& queryArchetypes(const ComponentMask& required);
+    const std::vector<std::unique_ptr<Archetype>>& getArchetypes() const { return archetypes; }
+
+    template<typename T>
+    T& addComponent(Entity entity, const T& value = T{}) {
+        T* component = static_cast<T*>(addComponent(entity, componentTypeID<T>()));
+        *component = value;
+        return *component;
+    }
+
+    template<typename T>
+    void removeComponent(Entity entity) {
+        removeComponent(entity, componentTypeID<T>());
+    }
+
+    template<typename T>
+    T* getComponent(Entity entity) {
+        if constexpr (std::is_const_v<T>) {
+            return static_cast<T*>(std::as_const(*this).getComponent(entity, componentTypeID<T>()));
+        } else {
+            return static_cast<T*>(getComponent(entity, componentTypeID<T>()));
+        }
+    }
+
+    template<typename T>
+    bool hasComponent(Entity entity) const {
+        return hasComponent(entity, componentTypeID<T>());
+    }
+
+    // Calls fn(archetype, chunk) for every non-empty chunk holding all of Ts.
+    template<typename... Ts, typename Fn>
+    void forEachChunk(Fn&& fn) {
+        for (Archetype* archetype : queryArchetypes(componentMask<Ts...>())) {
+            for (const Chunk& chunk : std::as_const(*archetype).getChunks()) {
+                if (chunk.count > 0) {
+                    fn(*archetype, chunk);
+                }
+            }
+        }
+    }
 };
 
 }
@@ -1,16 +1,20 @@
 #pragma once
 #include <memory>
 #include "spdlog/spdlog.h"
+#include "core/job_system.hpp"
 
 namespace Core {
 
 class Core {
 private:
     spdlog::logger coreLogger;
+    JobSystem jobSystem;
 
 public:
     Core();
     ~Core();
+
+    JobSystem& getJobSystem() { return jobSystem; }
 };
 
 }
@@ -1,5 +1,7 @@
 #pragma once
+#include <array>
 #include <memory>
+#include <span>
 #include <vector>
 #include "spdlog/spdlog.h"
 #include <immintrin.h>
@@ -9,11 +11,20 @@ namespace Core {
 struct Entity {
     uint32_t id;
     uint32_t generation;
+
+    bool operator==(const Entity&) const = default;
 };
 
+// Id 0 is never handed out, so a default constructed handle is always invalid.
+constexpr Entity NullEntity{0, 0};
+
+// Integrates a single axis stream: velocity += acceleration * dt, position += velocity * dt.
+using IntegrateAxisFn = void (*)(float* position, float* velocity, const float* acceleration, size_t count, float deltaTime);
+
 class EntityManager {
 private:
     spdlog::logger entityLogger;
+    // Dense arrays: entities[i] owns slot i of every component stream.
     std::vector<Entity> entities;
     std::vector<float> positionX;
     std::vector<float> positionY;
@@ -27,17 +38,43 @@ private:
     std::vector<float> rotationX;
     std::vector<float> rotationY;
     std::vector<float> rotationZ;
+    // Sparse table indexed by Entity::id, with a free list of recycled ids.
+    std::vector<uint32_t> denseIndices;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeIDs;
     uint32_t nextEntityID = 1;
+    IntegrateAxisFn integrateAxis;
+
+    std::array<std::vector<float>*, 12> streams();
 
 public:
     EntityManager();
     ~EntityManager();
 
-    void addEntity(const Entity& entity);
-    void removeEntity(unsigned int id);
+    void reserve(size_t count);
+    Entity addEntity();
+    void removeEntity(Entity entity);
+    void removeEntities(std::span<const Entity> toRemove);
     void updateEntities(float deltaTime);
     const std::vector<Entity>& getEntities() const;
-    Entity& getEntity(unsigned int id);
+    Entity getEntity(uint32_t id) const;
+    bool isAlive(Entity entity) const;
+    uint32_t getIndex(Entity entity) const;
+
+    void setPosition(Entity entity, float x, float y, float z);
+    void setVelocity(Entity entity, float x, float y, float z);
+    void setAcceleration(Entity entity, float x, float y, float z);
+    void setRotation(Entity entity, float x, float y, float z);
+
+    const std::vector<float>& getPositionX() const { return positionX; }
+    const std::vector<float>& getPositionY() const { return positionY; }
+    const std::vector<float>& getPositionZ() const { return positionZ; }
+    const std::vector<float>& getVelocityX() const { return velocityX; }
+    const std::vector<float>& getVelocityY() const { return velocityY; }
+    const std::vector<float>& getVelocityZ() const { return velocityZ; }
+    const std::vector<float>& getRotationX() const { return rotationX; }
+    const std::vector<float>& getRotationY() const { return rotationY; }
+    const std::vector<float>& getRotationZ() const { return rotationZ; }
 };
 
 }
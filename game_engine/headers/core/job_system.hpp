@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core {
+
+// Counts outstanding jobs. A counter reaching zero acts as a fence for everything submitted against it.
+class JobCounter {
+private:
+    std::atomic<uint32_t> pending{0};
+    friend class JobSystem;
+
+public:
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job {
+    std::function<void()> task;
+    JobCounter* counter;
+};
+
+// Chase-Lev work-stealing deque. Only the owning thread pushes and pops; any thread may steal.
+class WorkStealingDeque {
+private:
+    static constexpr int64_t Capacity = 4096;
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::unique_ptr<std::atomic<Job*>[]> buffer;
+
+public:
+    WorkStealingDeque();
+
+    bool push(Job* job);
+    Job* pop();
+    Job* steal();
+};
+
+class JobSystem {
+private:
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    std::vector<std::jthread> workers;
+
+    // Jobs from threads that do not own a deque.
+    std::mutex injectionMutex;
+    std::deque<Job*> injectionQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<uint32_t> queuedJobs{0};
+    std::atomic<uint32_t> sleepingWorkers{0};
+    std::atomic<bool> stopping{false};
+
+    void enqueue(Job* job);
+    Job* findJob(size_t thiefIndex);
+    void execute(Job* job);
+    void workerLoop(size_t index);
+    void wakeWorker();
+
+public:
+    // The constructing thread owns deque 0 and joins in while waiting; workerCount extra threads are spawned.
+    explicit JobSystem(size_t workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(std::function<void()> task, JobCounter* counter = nullptr);
+    // Runs other jobs until counter reaches zero, so waiting from inside a job never deadlocks the pool.
+    void wait(JobCounter& counter);
+    size_t getThreadCount() const { return deques.size(); }
+    // Index of the calling thread's deque. Threads outside the pool, which only run jobs while waiting,
+    // all get getThreadCount(), so per-thread state needs one extra slot for them.
+    size_t getThreadIndex() const;
+
+    // Calls fn(begin, end) over sub-ranges of [begin, end). Ranges are split lazily in halves down to
+    // a grain derived from the thread count, so idle threads steal the large halves first. If fn throws,
+    // sub-ranges not yet started are skipped and the first exception is rethrown once all jobs finished.
+    template<typename Fn>
+    void parallelFor(size_t begin, size_t end, Fn&& fn, size_t minGrain = 1) {
+        if (begin >= end) {
+            return;
+        }
+        const size_t grain = std::max(minGrain, (end - begin) / (getThreadCount() * 8));
+        ParallelForState state;
+        splitRange(begin, end, grain, fn, state);
+        // Queued halves reference state and fn on this stack, so wait even if this thread's part threw.
+        wait(state.counter);
+        if (state.exception) {
+            std::rethrow_exception(state.exception);
+        }
+    }
+
+private:
+    struct ParallelForState {
+        JobCounter counter;
+        std::atomic<bool> failed{false};
+        // Written once by the first job to fail; visible to the caller through the counter's release.
+        std::exception_ptr exception;
+    };
+
+    // Never throws: an exception escaping a job would terminate its worker.
+    template<typename Fn>
+    void splitRange(size_t begin, size_t end, size_t grain, Fn& fn, ParallelForState& state) {
+        try {
+            while (end - begin > grain) {
+                const size_t middle = begin + (end - begin) / 2;
+                submit([this, middle, end, grain, &fn, &state] {
+                    splitRange(middle, end, grain, fn, state);
+                }, &state.counter);
+                end = middle;
+            }
+            if (!state.failed.load(std::memory_order_relaxed)) {
+                fn(begin, end);
+            }
+        } catch (...) {
+            if (!state.failed.exchange(true)) {
+                state.exception = std::current_exception();
+            }
+        }
+    }
+};
+
+}
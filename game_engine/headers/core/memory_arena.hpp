@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace Core {
+
+constexpr size_t DefaultArenaPageSize = 1024 * 1024;
+constexpr size_t ArenaPageAlignment = 64;
+
+struct ArenaMarker {
+    size_t page;
+    size_t offset;
+};
+
+// Paged bump allocator. Allocations are never freed individually; rewinding to a marker or resetting
+// releases everything allocated after it at once while keeping the pages for reuse, so a long session
+// settles on a fixed set of pages instead of fragmenting the heap. Not thread safe.
+class MemoryArena {
+private:
+    struct Page {
+        std::byte* data;
+        size_t size;
+    };
+
+    std::vector<Page> pages;
+    size_t currentPage = 0;
+    size_t offset = 0;
+    size_t pageSize;
+
+    Page& allocatePage(size_t size, size_t position);
+
+public:
+    explicit MemoryArena(size_t pageSize = DefaultArenaPageSize);
+    ~MemoryArena();
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Storage for count default-initialised T. The arena never runs destructors.
+    template<typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena allocations are never destroyed");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    ArenaMarker getMarker() const { return ArenaMarker{currentPage, offset}; }
+    void rewind(ArenaMarker marker);
+    void reset() { rewind(ArenaMarker{0, 0}); }
+
+    size_t getUsedBytes() const;
+    size_t getReservedBytes() const;
+};
+
+// Fixed-size blocks carved out of an arena. Released blocks go on a free list instead of back to the
+// heap; the whole pool is dropped by resetting it together with its arena.
+class BlockPool {
+private:
+    MemoryArena& arena;
+    size_t blockSize;
+    size_t blockAlignment;
+    std::vector<std::byte*> freeBlocks;
+
+public:
+    BlockPool(MemoryArena& arena, size_t blockSize, size_t blockAlignment);
+
+    std::byte* acquire();
+    void release(std::byte* block);
+    // Forgets every free block. Call right before resetting the arena the blocks came from.
+    void reset();
+};
+
+}
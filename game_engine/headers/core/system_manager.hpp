@@ -1,16 +1,67 @@
 #pragma once
+#include <atomic>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "spdlog/spdlog.h"
+#include "core/job_system.hpp"
+#include "core/view.hpp"
 
 namespace Core {
 
+// Components a system reads and writes. Two systems conflict when either writes something the other touches.
+struct SystemAccess {
+    ComponentMask reads;
+    ComponentMask writes;
+
+    bool conflictsWith(const SystemAccess& other) const {
+        return (writes & (other.reads | other.writes)).any() || (other.writes & reads).any();
+    }
+
+    template<typename... Ts>
+    static SystemAccess of() {
+        return {View<Ts...>::getReadMask(), View<Ts...>::getWriteMask()};
+    }
+};
+
+using SystemFn = std::function<void(float deltaTime)>;
+using SystemID = uint32_t;
+
 class SystemManager {
 private:
+    struct SystemNode {
+        std::string name;
+        SystemAccess access;
+        SystemFn update;
+        std::vector<SystemID> dependents;
+        uint32_t dependencyCount = 0;
+        std::unique_ptr<std::atomic<uint32_t>> pendingDependencies = std::make_unique<std::atomic<uint32_t>>(0);
+    };
+
     spdlog::logger systemLogger;
+    JobSystem& jobSystem;
+    std::vector<SystemNode> systems;
+    bool graphDirty = false;
+
+    JobCounter frameCounter;
+    float frameDeltaTime = 0.0f;
+    std::mutex exceptionMutex;
+    std::exception_ptr frameException;
+
+    void buildGraph();
+    void runSystem(SystemID id);
 
 public:
-    SystemManager();
+    explicit SystemManager(JobSystem& jobSystem);
     ~SystemManager();
+
+    // Systems that conflict run in registration order; everything else may run in parallel.
+    SystemID addSystem(std::string name, SystemAccess access, SystemFn update);
+    void update(float deltaTime);
+    size_t getSystemCount() const { return systems.size(); }
 };
 
 }
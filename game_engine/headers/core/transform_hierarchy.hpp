@@ -0,0 +1,92 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "core/component_manager.hpp"
+#include "core/entity_manager.hpp"
+#include "math/matrix.hpp"
+#include "spdlog/spdlog.h"
+
+namespace Core {
+
+// ECS copy of a hierarchy node's world matrix, refreshed by TransformHierarchy::writeWorldTransforms.
+// previous holds the matrix as of the update before, so renderers can interpolate between updates;
+// it equals matrix once the node stops moving. Initialize both to the same matrix.
+struct WorldTransform {
+    Engine::Mat4 matrix;
+    Engine::Mat4 previous;
+};
+
+// Parent/child transforms stored in depth-first order, so every parent precedes its children and a
+// node's subtree occupies [node, node + subtreeSize). Local transforms are SoA streams; world matrices
+// are cached and only recomposed for nodes whose local transform or any ancestor changed. Added nodes
+// are appended and removed nodes are left as holes, and update() restores depth-first order in one pass,
+// so structural changes cost O(1) each plus O(n) once per update instead of O(n) each.
+class TransformHierarchy {
+private:
+    spdlog::logger transformLogger;
+
+    std::vector<Entity> entities;
+    std::vector<int32_t> parents;
+    std::vector<uint32_t> subtreeSizes;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+    std::vector<float> rotationX;
+    std::vector<float> rotationY;
+    std::vector<float> rotationZ;
+    std::vector<float> scaleX;
+    std::vector<float> scaleY;
+    std::vector<float> scaleZ;
+    std::vector<uint8_t> localDirty;
+    std::vector<uint8_t> worldDirty;
+    std::vector<Engine::Mat4> localMatrices;
+    std::vector<Engine::Mat4> worldMatrices;
+    // Indexed by Entity::id.
+    std::vector<uint32_t> nodeOf;
+    std::vector<uint32_t> changedNodes;
+    // Entities whose WorldTransform was written by the last writeWorldTransforms.
+    std::vector<Entity> writtenEntities;
+    // Set once a node was added under a parent or removed since the last rebuildLayout.
+    bool layoutDirty = false;
+    // Scratch of rebuildLayout.
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> newNodes;
+    std::vector<uint32_t> nextChild;
+
+    uint32_t findNode(Entity entity) const;
+    void dropNode(uint32_t node);
+    void rebuildLayout();
+
+public:
+    TransformHierarchy();
+    ~TransformHierarchy();
+
+    // Inserts entity as the last child of parent, or as a new root when parent is NullEntity.
+    void addNode(Entity entity, Entity parent = NullEntity);
+    // Removes entity together with its whole subtree. Descendants stay reachable until the next update.
+    void removeNode(Entity entity);
+    bool contains(Entity entity) const;
+
+    // Local positions and rotations are owned by the EntityManager streams and only enter the
+    // hierarchy through syncFromEntities; move nodes with EntityManager::setPosition and setRotation.
+    void setScale(Entity entity, float x, float y, float z);
+
+    // Pulls local positions and rotations from the entity streams, marking only nodes that moved, and
+    // removes the nodes of destroyed entities.
+    void syncFromEntities(const EntityManager& entityManager);
+    // Applies pending structural changes, recomposes dirty local matrices and propagates world matrices
+    // down dirty subtrees.
+    void update();
+    // Copies the world matrices that changed in the last update into the WorldTransform components of
+    // their entities, for entities that have one, and moves the replaced matrices into previous.
+    void writeWorldTransforms(ComponentManager& componentManager);
+
+    const Engine::Mat4& getWorldMatrix(Entity entity) const;
+    std::span<const Engine::Mat4> getWorldMatrices() const { return worldMatrices; }
+    std::span<const Entity> getEntities() const { return entities; }
+    // Nodes whose world matrix changed during the last update, in depth-first order.
+    std::span<const uint32_t> getChangedNodes() const { return changedNodes; }
+    uint32_t size() const { return static_cast<uint32_t>(entities.size()); }
+};
+
+}
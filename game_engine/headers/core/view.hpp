@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "core/component_manager.hpp"
+#include "core/job_system.hpp"
+
+namespace Core {
+
+// Typed query over every archetype holding all of Ts, e.g. View<Position, Velocity, const Mass>.
+// Const components are read-only; the read/write masks let a scheduler decide which systems may overlap.
+// Column offsets are resolved once per matching archetype, so the per-entity loops only see raw spans.
+// Iterating stamps the chunk columns of mutable components with a fresh change version, and a view
+// remembers the version of its previous pass so forEachChangedChunk can skip untouched chunks.
+template<typename... Ts>
+class View {
+    static_assert(sizeof...(Ts) > 0, "a view needs at least one component");
+
+private:
+    struct MatchedArchetype {
+        Archetype* archetype;
+        std::array<size_t, sizeof...(Ts)> offsets;
+        std::array<int32_t, sizeof...(Ts)> columns;
+    };
+
+    ComponentManager& componentManager;
+    std::vector<MatchedArchetype> matched;
+    size_t archetypesSeen = 0;
+    uint32_t levelGeneration = 0;
+    ChangeVersion lastRunVersion = 0;
+
+    ChangeVersion beginPass() {
+        const ChangeVersion version = componentManager.nextChangeVersion();
+        lastRunVersion = version;
+        return version;
+    }
+
+    void refresh() {
+        if (levelGeneration != componentManager.getLevelGeneration()) {
+            matched.clear();
+            archetypesSeen = 0;
+            levelGeneration = componentManager.getLevelGeneration();
+        }
+        const auto& archetypes = componentManager.queryArchetypes(getMask());
+        for (; archetypesSeen < archetypes.size(); archetypesSeen++) {
+            Archetype* archetype = archetypes[archetypesSeen];
+            matched.emplace_back(MatchedArchetype{
+                archetype,
+                {archetype->getColumnOffset(componentTypeID<Ts>())...},
+                {archetype->getColumn(componentTypeID<Ts>())...}
+            });
+        }
+    }
+
+    template<size_t... Is, typename Fn>
+    static void invokeChunk(const MatchedArchetype& match, Chunk& chunk, ChangeVersion version, Fn& fn, std::index_sequence<Is...>) {
+        ((std::is_const_v<Ts> ? void() : void(chunk.versions[match.columns[Is]] = version)), ...);
+        fn(
+            std::span<const Entity>(match.archetype->getEntities(chunk), chunk.count),
+            std::span<Ts>(reinterpret_cast<Ts*>(chunk.data + match.offsets[Is]), chunk.count)...
+        );
+    }
+
+public:
+    static constexpr bool isReadOnly = (std::is_const_v<Ts> && ...);
+
+    explicit View(ComponentManager& componentManager)
+        : componentManager{componentManager}, levelGeneration{componentManager.getLevelGeneration()} {
+    }
+
+    static ComponentMask getMask() {
+        return componentMask<Ts...>();
+    }
+
+    static ComponentMask getReadMask() {
+        ComponentMask mask;
+        ((std::is_const_v<Ts> ? mask.set(componentTypeID<Ts>()) : mask), ...);
+        return mask;
+    }
+
+    static ComponentMask getWriteMask() {
+        ComponentMask mask;
+        ((!std::is_const_v<Ts> ? mask.set(componentTypeID<Ts>()) : mask), ...);
+        return mask;
+    }
+
+    ChangeVersion getLastRunVersion() const { return lastRunVersion; }
+
+    // fn(std::span<const Entity>, std::span<Ts>...) once per non-empty chunk.
+    template<typename Fn>
+    void forEachChunk(Fn&& fn) {
+        refresh();
+        const ChangeVersion version = beginPass();
+        for (const MatchedArchetype& match : matched) {
+            for (Chunk& chunk : match.archetype->getChunks()) {
+                if (chunk.count > 0) {
+                    invokeChunk(match, chunk, version, fn, std::index_sequence_for<Ts...>{});
+                }
+            }
+        }
+    }
+
+    // Like forEachChunk, but only for chunks whose Changed column was written since this view's previous pass.
+    template<typename Changed, typename Fn>
+    void forEachChangedChunk(Fn&& fn) {
+        static_assert((std::is_same_v<std::remove_const_t<Changed>, std::remove_const_t<Ts>> || ...),
+            "the changed component must be one of the view's components");
+        refresh();
+        const ChangeVersion since = lastRunVersion;
+        const ChangeVersion version = beginPass();
+        const ComponentTypeID changedType = componentTypeID<Changed>();
+        for (const MatchedArchetype& match : matched) {
+            const int32_t column = match.archetype->getColumn(changedType);
+            for (Chunk& chunk : match.archetype->getChunks()) {
+                if (chunk.count > 0 && chunk.versions[column] > since) {
+                    invokeChunk(match, chunk, version, fn, std::index_sequence_for<Ts...>{});
+                }
+            }
+        }
+    }
+
+    // Same as forEachChunk, with chunks spread over the job system. fn must be safe to call concurrently.
+    template<typename Fn>
+    void forEachChunkParallel(JobSystem& jobSystem, Fn&& fn) {
+        refresh();
+        const ChangeVersion version = beginPass();
+        std::vector<std::pair<const MatchedArchetype*, Chunk*>> work;
+        for (const MatchedArchetype& match : matched) {
+            for (Chunk& chunk : match.archetype->getChunks()) {
+                if (chunk.count > 0) {
+                    work.emplace_back(&match, &chunk);
+                }
+            }
+        }
+        jobSystem.parallelFor(0, work.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                invokeChunk(*work[i].first, *work[i].second, version, fn, std::index_sequence_for<Ts...>{});
+            }
+        });
+    }
+
+    // fn(Ts&...) or fn(Entity, Ts&...) once per entity.
+    template<typename Fn>
+    void each(Fn&& fn) {
+        forEachChunk([&fn](std::span<const Entity> entities, std::span<Ts>... columns) {
+            for (size_t i = 0; i < entities.size(); i++) {
+                if constexpr (std::is_invocable_v<Fn&, Entity, Ts&...>) {
+                    fn(entities[i], columns[i]...);
+                } else {
+                    fn(columns[i]...);
+                }
+            }
+        });
+    }
+
+    size_t size() {
+        refresh();
+        size_t count = 0;
+        for (const MatchedArchetype& match : matched) {
+            count += match.archetype->size();
+        }
+        return count;
+    }
+};
+
+}
@@ -1,9 +1,11 @@
 #pragma once 
 #include <memory>
 #include "core/system_manager.hpp"
+#include "core/command_buffer.hpp"
 #include "core/component_manager.hpp"
 #include "core/entity_manager.hpp"
 #include "core/scene_manager.hpp"
+#include "core/transform_hierarchy.hpp"
 #include "core/resource_manager.hpp"
 #include "core/core.hpp"
 #include "spdlog/spdlog.h"
@@ -20,6 +22,10 @@ private:
     std::unique_ptr<Core::ComponentManager> componentManager;
     std::unique_ptr<Core::SceneManager> sceneManager;
     std::unique_ptr<Core::Core> coreSystems;
+    std::unique_ptr<Core::EntityCommandQueue> entityCommands;
+    std::unique_ptr<Core::TransformHierarchy> transformHierarchy;
+    // Frame lifetime: rewound at the start of every update.
+    std::unique_ptr<Core::MemoryArena> frameArena;
 
 public:
     GameEngine();
@@ -28,7 +34,17 @@ public:
     void initialize();
     void update(float deltaTime);
     void shutdown();
-    
+
+    Core::Core& getCore() { return *coreSystems; }
+    Core::SystemManager& getSystemManager() { return *systemManager; }
+    Core::EntityManager& getEntityManager() { return *entityManager; }
+    Core::ComponentManager& getComponentManager() { return *componentManager; }
+    // Systems record entity and component changes here; they are applied after all systems finish.
+    Core::EntityCommandQueue& getEntityCommands() { return *entityCommands; }
+    Core::TransformHierarchy& getTransformHierarchy() { return *transformHierarchy; }
+    // Scratch memory that stays valid until the next update. Main thread only.
+    Core::MemoryArena& getFrameArena() { return *frameArena; }
+
 };
 
 }
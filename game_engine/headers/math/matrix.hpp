@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+
+namespace Engine {
+
+// Column-major 4x4 matrix, laid out like glm::mat4 so it can be copied straight into GPU buffers.
+struct alignas(16) Mat4 {
+    float m[16];
+
+    static Mat4 identity();
+};
+
+// out = a * b using SSE column combinations. out may alias neither input.
+void multiply(const Mat4& a, const Mat4& b, Mat4& out);
+
+// Builds translation * rotation(Z * Y * X, radians) * scale for count transforms stored as SoA streams.
+// Four transforms at a time go through SSE with a polynomial sine and cosine, accurate to a few ulp
+// for angles within a few thousand radians; the remainder uses std::sin and std::cos.
+void composeTransforms(
+    const float* positionX, const float* positionY, const float* positionZ,
+    const float* rotationX, const float* rotationY, const float* rotationZ,
+    const float* scaleX, const float* scaleY, const float* scaleZ,
+    size_t count, Mat4* out
+);
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "core/transform_hierarchy.hpp"
+#include "core/view.hpp"
+#include "spdlog/spdlog.h"
+
+namespace Rendering {
+
+// Draws the entity as one instance of mesh, placed by its Core::WorldTransform.
+struct MeshInstance {
+    uint32_t mesh;
+    float color[4];
+};
+
+// GPU layout of one instance: the affine rows of the model matrix and a colour. 64 bytes, so instance
+// arrays can start at any 64-byte aligned buffer offset and be addressed with firstInstance.
+struct InstanceData {
+    float modelRows[3][4];
+    float color[4];
+};
+static_assert(sizeof(InstanceData) == 64);
+
+struct InstanceBatch {
+    uint32_t mesh;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+// Packs every entity with a WorldTransform and a MeshInstance into a flat instance array grouped by
+// mesh, so each mesh is drawn with a single instanced call.
+class InstanceBatcher {
+private:
+    spdlog::logger batcherLogger;
+    Core::View<const Core::WorldTransform, const MeshInstance> instances;
+    std::vector<uint32_t> meshCursors;
+    std::vector<uint32_t> meshEnds;
+    // Whether the last pack had more instances than out could hold; warns once per overflow.
+    bool truncated = false;
+    std::vector<InstanceBatch> batches;
+
+public:
+    explicit InstanceBatcher(Core::ComponentManager& componentManager);
+    ~InstanceBatcher();
+
+    size_t countInstances() { return instances.size(); }
+    // Fills out with up to out.size() instances and leaves the rest out of the batches. Each mesh's
+    // range is filled in order, but entities of different meshes interleave across ranges, so out should
+    // be cached memory rather than a write-combined GPU mapping. Model matrices are blended from
+    // WorldTransform::previous (alpha 0) to WorldTransform::matrix (alpha 1).
+    const std::vector<InstanceBatch>& pack(std::span<InstanceData> out, float alpha = 1.0f);
+    // Batches from the last pack, with firstInstance relative to the start of out.
+    const std::vector<InstanceBatch>& getBatches() const { return batches; }
+};
+
+}
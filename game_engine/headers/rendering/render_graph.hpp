@@ -0,0 +1,188 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+namespace Rendering {
+
+using RenderResource = uint32_t;
+using RenderPassHandle = uint32_t;
+
+// How a pass touches a resource. A backend maps every access to its pipeline stages, memory access
+// flags and, for textures, image layout.
+enum class ResourceAccess : uint8_t {
+    None,
+    ColorAttachmentWrite,
+    DepthAttachmentWrite,
+    DepthAttachmentRead,
+    VertexShaderRead,
+    FragmentShaderRead,
+    ComputeShaderRead,
+    ComputeShaderWrite,
+    IndirectRead,
+    TransferRead,
+    TransferWrite,
+    Present
+};
+
+using AccessMask = uint32_t;
+
+constexpr AccessMask accessBit(ResourceAccess access) {
+    return access == ResourceAccess::None ? 0 : 1u << static_cast<uint32_t>(access);
+}
+
+constexpr AccessMask WriteAccesses = accessBit(ResourceAccess::ColorAttachmentWrite) | accessBit(ResourceAccess::DepthAttachmentWrite)
+    | accessBit(ResourceAccess::ComputeShaderWrite) | accessBit(ResourceAccess::TransferWrite);
+
+enum class TextureLayout : uint8_t {
+    Undefined,
+    General,
+    ColorAttachment,
+    DepthAttachment,
+    DepthReadOnly,
+    ShaderReadOnly,
+    TransferSource,
+    TransferDestination,
+    Present
+};
+
+// The single layout that serves every access in access, or General when they disagree.
+TextureLayout textureLayoutFor(AccessMask access);
+
+enum class RenderResourceType : uint8_t {
+    Texture,
+    Buffer
+};
+
+// format is opaque to the graph and interpreted by the backend.
+struct TextureDesc {
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+
+    bool operator==(const TextureDesc&) const = default;
+};
+
+struct MemoryRequirement {
+    uint64_t size;
+    uint64_t alignment;
+    uint32_t typeBits;
+};
+
+// Everything a pass needs to wait for before it touches resource. oldLayout is Undefined when the
+// contents may be discarded, i.e. on the first use of a transient resource.
+struct ResourceBarrier {
+    RenderResource resource;
+    AccessMask before;
+    AccessMask after;
+    TextureLayout oldLayout;
+    TextureLayout newLayout;
+};
+
+// A frame's passes and the resources they read and write, rebuilt every frame. Passes run in the
+// order they were added, so a pass must be added after the passes producing what it reads. compile()
+// culls passes that contribute nothing to an output, derives the barriers and layout transitions each
+// remaining pass needs, and packs transient resources whose lifetimes don't overlap into shared
+// memory slots. Recording the passes is left to a backend.
+class RenderGraph {
+private:
+    struct Resource {
+        const char* name;
+        RenderResourceType type;
+        bool imported = false;
+        bool discard = false;
+        bool output = false;
+        TextureDesc texture{};
+        uint64_t size = 0;
+        AccessMask initialAccess = 0;
+        AccessMask finalAccess = 0;
+        AccessMask usage = 0;
+        MemoryRequirement memory{};
+        // First and last surviving pass that touches the resource, filled in by compile().
+        uint32_t firstPass = 0;
+        uint32_t lastPass = 0;
+        int32_t aliasSlot = -1;
+    };
+
+    struct PassAccess {
+        RenderResource resource;
+        AccessMask access;
+    };
+
+    struct Pass {
+        const char* name;
+        std::vector<PassAccess> accesses{};
+        bool sideEffects = false;
+        bool culled = false;
+        std::vector<ResourceBarrier> barriers{};
+    };
+
+    struct AliasSlot {
+        RenderResourceType type;
+        MemoryRequirement memory;
+        std::vector<RenderResource> resources;
+    };
+
+    spdlog::logger graphLogger;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<AliasSlot> aliasSlots;
+    std::vector<ResourceBarrier> finalBarriers;
+
+    RenderResource addResource(const Resource& resource);
+    void cullPasses();
+    void computeLifetimes();
+    void assignAliasSlots();
+    void computeBarriers();
+
+public:
+    RenderGraph();
+    ~RenderGraph();
+
+    void reset();
+
+    // Imported resources outlive the graph. current is how the previous user left it; discard allows
+    // its contents, and therefore its layout, to be thrown away on first use.
+    RenderResource importTexture(const char* name, const TextureDesc& desc, ResourceAccess current, bool discard);
+    RenderResource importBuffer(const char* name, uint64_t size, AccessMask current);
+    // Transient resources only live for the frame and may share memory with each other.
+    RenderResource createTexture(const char* name, const TextureDesc& desc);
+    RenderResource createBuffer(const char* name, uint64_t size);
+    // Keeps the passes producing resource alive and transitions it to finalAccess after the last pass.
+    void markOutput(RenderResource resource, ResourceAccess finalAccess);
+
+    RenderPassHandle addPass(const char* name);
+    // Passes with side effects outside the graph are never culled.
+    void setSideEffects(RenderPassHandle pass);
+    // Repeated accesses of one resource by one pass are merged.
+    void access(RenderPassHandle pass, RenderResource resource, ResourceAccess access);
+
+    // Must be set for every transient resource that should take part in aliasing.
+    void setMemoryRequirement(RenderResource resource, const MemoryRequirement& requirement);
+    void compile();
+
+    size_t getPassCount() const { return passes.size(); }
+    const char* getPassName(RenderPassHandle pass) const { return passes[pass].name; }
+    bool isCulled(RenderPassHandle pass) const { return passes[pass].culled; }
+    std::span<const ResourceBarrier> getBarriers(RenderPassHandle pass) const { return passes[pass].barriers; }
+    std::span<const ResourceBarrier> getFinalBarriers() const { return finalBarriers; }
+
+    size_t getResourceCount() const { return resources.size(); }
+    const char* getResourceName(RenderResource resource) const { return resources[resource].name; }
+    RenderResourceType getResourceType(RenderResource resource) const { return resources[resource].type; }
+    bool isImported(RenderResource resource) const { return resources[resource].imported; }
+    const TextureDesc& getTextureDesc(RenderResource resource) const { return resources[resource].texture; }
+    uint64_t getBufferSize(RenderResource resource) const { return resources[resource].size; }
+    // Every access any pass declared for resource, culled or not.
+    AccessMask getUsage(RenderResource resource) const { return resources[resource].usage; }
+    // True when a pass that survived culling touches resource.
+    bool isUsed(RenderResource resource) const;
+
+    // -1 for imported and unused resources and those without a memory requirement.
+    int32_t getAliasSlot(RenderResource resource) const { return resources[resource].aliasSlot; }
+    size_t getAliasSlotCount() const { return aliasSlots.size(); }
+    const MemoryRequirement& getAliasSlotRequirement(size_t slot) const { return aliasSlots[slot].memory; }
+};
+
+}
@@ -0,0 +1,177 @@
+#include "core/archetype.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+std::array<Core::ComponentInfo, Core::MaxComponents> componentInfos;
+std::atomic<uint32_t> componentTypeCount{0};
+std::mutex registryMutex;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+namespace Core {
+
+ComponentTypeID registerComponentType(size_t size, size_t alignment, const char* name) {
+    std::scoped_lock lock(registryMutex);
+    const uint32_t id = componentTypeCount.load();
+    if (id >= MaxComponents) {
+        throw std::runtime_error("too many component types registered!");
+    }
+    componentInfos[id] = ComponentInfo{size, alignment, name};
+    componentTypeCount.store(id + 1);
+    return id;
+}
+
+const ComponentInfo& getComponentInfo(ComponentTypeID type) {
+    return componentInfos[type];
+}
+
+Archetype::Archetype(const ComponentMask& mask, BlockPool& chunkPool)
+    : mask{mask}, chunkPool{chunkPool} {
+    columnOf.fill(-1);
+    for (ComponentTypeID type = 0; type < MaxComponents; type++) {
+        if (mask.test(type)) {
+            columnOf[type] = static_cast<int32_t>(types.size());
+            types.emplace_back(type);
+            columnSizes.emplace_back(getComponentInfo(type).size);
+        }
+    }
+
+    size_t rowSize = sizeof(Entity);
+    for (size_t size : columnSizes) {
+        rowSize += size;
+    }
+
+    // Shrink the capacity until every column, padded to a cache line, fits in one chunk.
+    auto layoutSize = [&](uint32_t capacity) {
+        size_t offset = sizeof(Entity) * capacity;
+        for (size_t column = 0; column < types.size(); column++) {
+            const size_t alignment = std::max(ChunkColumnAlignment, getComponentInfo(types[column]).alignment);
+            offset = alignUp(offset, alignment) + columnSizes[column] * capacity;
+        }
+        return offset;
+    };
+    chunkCapacity = static_cast<uint32_t>(ChunkSize / rowSize);
+    while (chunkCapacity > 1 && layoutSize(chunkCapacity) > ChunkSize) {
+        chunkCapacity--;
+    }
+    if (chunkCapacity == 0 || layoutSize(chunkCapacity) > ChunkSize) {
+        throw std::runtime_error("archetype row does not fit in a chunk!");
+    }
+
+    size_t offset = sizeof(Entity) * chunkCapacity;
+    for (size_t column = 0; column < types.size(); column++) {
+        const size_t alignment = std::max(ChunkColumnAlignment, getComponentInfo(types[column]).alignment);
+        offset = alignUp(offset, alignment);
+        columnOffsets.emplace_back(offset);
+        offset += columnSizes[column] * chunkCapacity;
+    }
+}
+
+Archetype::~Archetype() {
+    for (auto& chunk : chunks) {
+        chunkPool.release(chunk.data);
+    }
+}
+
+Chunk& Archetype::allocateChunk(ChangeVersion version) {
+    return chunks.emplace_back(Chunk{chunkPool.acquire(), 0, std::vector<ChangeVersion>(types.size(), version)});
+}
+
+void Archetype::markChanged(Chunk& chunk, ChangeVersion version) {
+    std::fill(chunk.versions.begin(), chunk.versions.end(), version);
+}
+
+void Archetype::markColumnChanged(ComponentTypeID type, uint32_t slot, ChangeVersion version) {
+    chunks[slot / chunkCapacity].versions[columnOf[type]] = version;
+}
+
+uint32_t Archetype::addRow(Entity entity, ChangeVersion version) {
+    const uint32_t slot = entityCount;
+    const uint32_t chunkIndex = slot / chunkCapacity;
+    if (chunkIndex == chunks.size()) {
+        allocateChunk(version);
+    }
+
+    Chunk& chunk = chunks[chunkIndex];
+    markChanged(chunk, version);
+    const uint32_t row = chunk.count++;
+    getEntities(chunk)[row] = entity;
+    for (size_t column = 0; column < types.size(); column++) {
+        std::memset(chunk.data + columnOffsets[column] + columnSizes[column] * row, 0, columnSizes[column]);
+    }
+    entityCount++;
+    return slot;
+}
+
+uint32_t Archetype::addRows(std::span<const Entity> newEntities, ChangeVersion version) {
+    const uint32_t first = entityCount;
+    size_t added = 0;
+    while (added < newEntities.size()) {
+        const uint32_t chunkIndex = entityCount / chunkCapacity;
+        if (chunkIndex == chunks.size()) {
+            allocateChunk(version);
+        }
+
+        Chunk& chunk = chunks[chunkIndex];
+        markChanged(chunk, version);
+        const uint32_t row = chunk.count;
+        const uint32_t run = static_cast<uint32_t>(std::min<size_t>(chunkCapacity - row, newEntities.size() - added));
+        std::memcpy(getEntities(chunk) + row, newEntities.data() + added, run * sizeof(Entity));
+        for (size_t column = 0; column < types.size(); column++) {
+            std::memset(chunk.data + columnOffsets[column] + columnSizes[column] * row, 0, columnSizes[column] * run);
+        }
+        chunk.count += run;
+        entityCount += run;
+        added += run;
+    }
+    return first;
+}
+
+Entity Archetype::removeRow(uint32_t slot, ChangeVersion version) {
+    const uint32_t last = entityCount - 1;
+    Chunk& chunk = chunks[slot / chunkCapacity];
+    Chunk& lastChunk = chunks[last / chunkCapacity];
+    const uint32_t row = slot % chunkCapacity;
+    const uint32_t lastRow = last % chunkCapacity;
+
+    Entity moved = NullEntity;
+    if (slot != last) {
+        moved = getEntities(lastChunk)[lastRow];
+        getEntities(chunk)[row] = moved;
+        markChanged(chunk, version);
+        for (size_t column = 0; column < types.size(); column++) {
+            const size_t size = columnSizes[column];
+            std::memcpy(chunk.data + columnOffsets[column] + size * row, lastChunk.data + columnOffsets[column] + size * lastRow, size);
+        }
+    }
+
+    lastChunk.count--;
+    entityCount--;
+    // Keep one spare chunk around so an entity bouncing across a chunk boundary does not thrash the pool.
+    if (chunks.size() > 1 && chunks.back().count == 0 && chunks[chunks.size() - 2].count == 0) {
+        chunkPool.release(chunks.back().data);
+        chunks.pop_back();
+    }
+    return moved;
+}
+
+void* Archetype::getComponent(ComponentTypeID type, uint32_t slot) {
+    const int32_t column = columnOf[type];
+    Chunk& chunk = chunks[slot / chunkCapacity];
+    return chunk.data + columnOffsets[column] + columnSizes[column] * (slot % chunkCapacity);
+}
+
+Entity Archetype::getEntity(uint32_t slot) const {
+    return getEntities(chunks[slot / chunkCapacity])[slot % chunkCapacity];
+}
+
+}
@@ -0,0 +1,261 @@
+#include "core/command_buffer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <unordered_map>
+
+namespace {
+
+std::atomic<uint64_t> nextQueueID{1};
+
+struct ResolvedCommand {
+    Core::Entity entity;
+    Core::EntityCommandType type;
+    Core::ComponentTypeID component;
+    const std::byte* payload;
+};
+
+struct MoveKey {
+    Core::Archetype* source;
+    Core::ComponentMask target;
+
+    bool operator==(const MoveKey&) const = default;
+};
+
+struct MoveKeyHash {
+    size_t operator()(const MoveKey& key) const {
+        return std::hash<Core::ComponentMask>{}(key.target) ^ (std::hash<Core::Archetype*>{}(key.source) << 1);
+    }
+};
+
+struct PendingMove {
+    MoveKey key;
+    size_t hash;
+    Core::Entity entity;
+};
+
+// Orders masks by their lowest differing component bit.
+bool maskLess(const Core::ComponentMask& a, const Core::ComponentMask& b) {
+    const Core::ComponentMask difference = a ^ b;
+    if (difference.none()) {
+        return false;
+    }
+    size_t bit = 0;
+    while (!difference[bit]) {
+        bit++;
+    }
+    return b[bit];
+}
+
+// Total order on (hash, source, target): the hash decides almost always, the key only breaks ties so
+// that distinct keys sharing a hash can't interleave.
+bool pendingMoveLess(const PendingMove& a, const PendingMove& b) {
+    if (a.hash != b.hash) {
+        return a.hash < b.hash;
+    }
+    if (a.key.source != b.key.source) {
+        return std::less<Core::Archetype*>{}(a.key.source, b.key.source);
+    }
+    return maskLess(a.key.target, b.key.target);
+}
+
+struct ComponentWrite {
+    Core::Entity entity;
+    Core::ComponentTypeID component;
+    const std::byte* payload;
+};
+
+}
+
+namespace Core {
+
+Entity EntityCommandBuffer::createEntity() {
+    const Entity entity{PendingEntityBit | pendingEntities++, bufferIndex};
+    commands.emplace_back(EntityCommand{EntityCommandType::Create, 0, entity, 0});
+    return entity;
+}
+
+void EntityCommandBuffer::destroyEntity(Entity entity) {
+    commands.emplace_back(EntityCommand{EntityCommandType::Destroy, 0, entity, 0});
+}
+
+void EntityCommandBuffer::removeComponent(Entity entity, ComponentTypeID type) {
+    commands.emplace_back(EntityCommand{EntityCommandType::RemoveComponent, type, entity, 0});
+}
+
+void EntityCommandBuffer::addComponent(Entity entity, ComponentTypeID type, const void* value, size_t size) {
+    const uint32_t offset = static_cast<uint32_t>(payload.size());
+    payload.resize(payload.size() + size);
+    std::memcpy(payload.data() + offset, value, size);
+    commands.emplace_back(EntityCommand{EntityCommandType::AddComponent, type, entity, offset});
+}
+
+void EntityCommandBuffer::clear() {
+    commands.clear();
+    payload.clear();
+    pendingEntities = 0;
+}
+
+EntityCommandQueue::EntityCommandQueue()
+    : queueID{nextQueueID.fetch_add(1)} {
+}
+
+EntityCommandBuffer& EntityCommandQueue::local() {
+    // One buffer per queue and thread, so alternating between queues never allocates again. Ids are
+    // never reused, so an entry left by a destroyed queue can not be mistaken for ours.
+    thread_local std::unordered_map<uint64_t, EntityCommandBuffer*> cachedBuffers;
+    EntityCommandBuffer*& buffer = cachedBuffers[queueID];
+    if (!buffer) {
+        std::scoped_lock lock(buffersMutex);
+        buffers.emplace_back(std::make_unique<EntityCommandBuffer>(static_cast<uint32_t>(buffers.size())));
+        buffer = buffers.back().get();
+    }
+    return *buffer;
+}
+
+void EntityCommandQueue::playback(EntityManager& entityManager, ComponentManager& componentManager, MemoryArena& scratch) {
+    std::scoped_lock lock(buffersMutex);
+    const ArenaMarker scratchStart = scratch.getMarker();
+
+    size_t commandCount = 0;
+    for (auto& buffer : buffers) {
+        commandCount += buffer->commands.size();
+    }
+    std::span<ResolvedCommand> resolved(scratch.allocateArray<ResolvedCommand>(commandCount), commandCount);
+    size_t resolvedCount = 0;
+
+    for (auto& buffer : buffers) {
+        Entity* created = scratch.allocateArray<Entity>(buffer->pendingEntities);
+        for (uint32_t i = 0; i < buffer->pendingEntities; i++) {
+            created[i] = entityManager.addEntity();
+        }
+
+        for (const EntityCommand& command : buffer->commands) {
+            if (command.type == EntityCommandType::Create) {
+                continue;
+            }
+            Entity entity = command.entity;
+            if (entity.id & PendingEntityBit) {
+                // A pending handle carries the index of the buffer that created it and only resolves there.
+                const uint32_t index = entity.id & ~PendingEntityBit;
+                const bool valid = entity.generation == buffer->bufferIndex && index < buffer->pendingEntities;
+                assert(valid && "pending entity used outside the buffer that created it");
+                if (!valid) {
+                    continue;
+                }
+                entity = created[index];
+            }
+            resolved[resolvedCount++] = ResolvedCommand{
+                entity,
+                command.type,
+                command.component,
+                buffer->payload.data() + command.payloadOffset
+            };
+        }
+    }
+    resolved = resolved.first(resolvedCount);
+
+    // Group by entity while keeping each thread's recording order. Stale handles of a recycled id form
+    // their own group instead of masking the live entity's commands.
+    std::stable_sort(resolved.begin(), resolved.end(), [](const ResolvedCommand& a, const ResolvedCommand& b) {
+        return a.entity.id != b.entity.id ? a.entity.id < b.entity.id : a.entity.generation < b.entity.generation;
+    });
+
+    // Every list is bounded by the number of resolved commands.
+    PendingMove* moves = scratch.allocateArray<PendingMove>(resolved.size());
+    ComponentWrite* writes = scratch.allocateArray<ComponentWrite>(resolved.size());
+    Entity* destroyed = scratch.allocateArray<Entity>(resolved.size());
+    size_t moveCount = 0;
+    size_t writeCount = 0;
+    size_t destroyedCount = 0;
+    const auto addMove = [&](Archetype* source, const ComponentMask& target, Entity entity) {
+        const MoveKey key{source, target};
+        moves[moveCount++] = PendingMove{key, MoveKeyHash{}(key), entity};
+    };
+
+    for (size_t begin = 0; begin < resolved.size();) {
+        size_t end = begin;
+        while (end < resolved.size() && resolved[end].entity == resolved[begin].entity) {
+            end++;
+        }
+
+        const Entity entity = resolved[begin].entity;
+        if (!entityManager.isAlive(entity)) {
+            begin = end;
+            continue;
+        }
+        const EntityLocation* location = componentManager.getLocation(entity);
+        Archetype* source = location ? location->archetype : nullptr;
+        const ComponentMask sourceMask = source ? source->getMask() : ComponentMask{};
+        ComponentMask mask = sourceMask;
+        bool isDestroyed = false;
+        // This entity's writes are appended to writes and rolled back if it ends up destroyed.
+        const size_t entityWrites = writeCount;
+        const auto dropWrites = [&](ComponentTypeID component) {
+            writeCount = std::remove_if(writes + entityWrites, writes + writeCount, [&](const ComponentWrite& write) {
+                return write.component == component;
+            }) - writes;
+        };
+
+        // Fold every command for this entity into one net structural change.
+        for (size_t i = begin; i < end && !isDestroyed; i++) {
+            const ResolvedCommand& command = resolved[i];
+            switch (command.type) {
+                case EntityCommandType::Destroy:
+                    isDestroyed = true;
+                    break;
+                case EntityCommandType::AddComponent:
+                    mask.set(command.component);
+                    dropWrites(command.component);
+                    writes[writeCount++] = ComponentWrite{entity, command.component, command.payload};
+                    break;
+                case EntityCommandType::RemoveComponent:
+                    mask.reset(command.component);
+                    dropWrites(command.component);
+                    break;
+                case EntityCommandType::Create:
+                    break;
+            }
+        }
+
+        if (isDestroyed) {
+            writeCount = entityWrites;
+            destroyed[destroyedCount++] = entity;
+            if (source) {
+                addMove(source, ComponentMask{}, entity);
+            }
+        } else if (mask != sourceMask) {
+            addMove(source, mask, entity);
+        }
+        begin = end;
+    }
+
+    // Sorting by hash first is cheap and the key tie-break makes equal keys contiguous, so every
+    // (source, target) pair becomes exactly one batch.
+    std::sort(moves, moves + moveCount, pendingMoveLess);
+    Entity* moveEntities = scratch.allocateArray<Entity>(moveCount);
+    for (size_t i = 0; i < moveCount; i++) {
+        moveEntities[i] = moves[i].entity;
+    }
+    for (size_t begin = 0; begin < moveCount;) {
+        size_t end = begin + 1;
+        while (end < moveCount && moves[end].key == moves[begin].key) {
+            end++;
+        }
+        componentManager.moveEntities(moves[begin].key.source, moves[begin].key.target, std::span<const Entity>(moveEntities + begin, end - begin));
+        begin = end;
+    }
+    for (size_t i = 0; i < writeCount; i++) {
+        std::memcpy(componentManager.getComponent(writes[i].entity, writes[i].component), writes[i].payload, getComponentInfo(writes[i].component).size);
+    }
+    for (size_t i = 0; i < destroyedCount; i++) {
+        entityManager.removeEntity(destroyed[i]);
+    }
+
+    for (auto& buffer : buffers) {
+        buffer->clear();
+    }
+    scratch.rewind(scratchStart);
+}
+
+}
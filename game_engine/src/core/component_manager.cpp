@@ -1,11 +1,15 @@
 #include "core/component_manager.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
 #include "utils/utils.hpp"
 
 namespace Core {
 
 ComponentManager::ComponentManager() 
-    : componentLogger{Utils::initLogger("ComponentManager", spdlog::level::debug)} {
+    : componentLogger{Utils::initLogger("ComponentManager", spdlog::level::debug)},
+      levelArena{ChunkSize * 64},
+      chunkPool{levelArena, ChunkSize, ChunkColumnAlignment} {
     componentLogger.debug("Component Manager Initialized");
 }
 
@@ -13,4 +17,242 @@ ComponentManager::~ComponentManager() {
     componentLogger.debug("Component Manager Shutdown");
 }
 
+Archetype* ComponentManager::getOrCreateArchetype(const ComponentMask& mask) {
+    if (mask.none()) {
+        return nullptr;
+    }
+    if (auto it = archetypeByMask.find(mask); it != archetypeByMask.end()) {
+        return it->second;
+    }
+
+    auto& archetype = archetypes.emplace_back(std::make_unique<Archetype>(mask, chunkPool));
+    archetypeByMask.emplace(mask, archetype.get());
+    componentLogger.debug("Created archetype {} with {} components, {} entities per chunk", 
+        archetypes.size() - 1, archetype->getTypes().size(), archetype->getChunkCapacity());
+    return archetype.get();
+}
+
+EntityLocation* ComponentManager::findLocation(Entity entity) {
+    if (entity.id >= locations.size() || locations[entity.id].generation != entity.generation) {
+        return nullptr;
+    }
+    return &locations[entity.id];
+}
+
+const EntityLocation* ComponentManager::getLocation(Entity entity) const {
+    if (entity.id >= locations.size() || locations[entity.id].generation != entity.generation) {
+        return nullptr;
+    }
+    return &locations[entity.id];
+}
+
+void ComponentManager::moveEntity(Entity entity, EntityLocation& location, Archetype* target, ChangeVersion version) {
+    Archetype* source = location.archetype;
+    const uint32_t oldSlot = location.slot;
+    const uint32_t newSlot = target ? target->addRow(entity, version) : 0;
+
+    if (source) {
+        if (target) {
+            for (ComponentTypeID type : source->getTypes()) {
+                if (target->hasComponent(type)) {
+                    std::memcpy(target->getComponent(type, newSlot), source->getComponent(type, oldSlot), getComponentInfo(type).size);
+                }
+            }
+        }
+        const Entity moved = source->removeRow(oldSlot, version);
+        if (moved != NullEntity) {
+            locations[moved.id].slot = oldSlot;
+        }
+    }
+
+    location.archetype = target;
+    location.slot = newSlot;
+}
+
+void* ComponentManager::addComponent(Entity entity, ComponentTypeID type) {
+    if (entity.id >= locations.size()) {
+        locations.resize(entity.id + 1);
+    }
+
+    EntityLocation& location = locations[entity.id];
+    if (location.generation != entity.generation) {
+        // The id was recycled without its previous owner being removed here; drop the stale row.
+        moveEntity(NullEntity, location, nullptr, getWriteVersion());
+        location.generation = entity.generation;
+    }
+
+    Archetype* source = location.archetype;
+    if (source && source->hasComponent(type)) {
+        source->markColumnChanged(type, location.slot, getWriteVersion());
+        return source->getComponent(type, location.slot);
+    }
+
+    Archetype* target = source ? source->addEdges[type] : nullptr;
+    if (!target) {
+        ComponentMask mask = source ? source->getMask() : ComponentMask{};
+        target = getOrCreateArchetype(mask.set(type));
+        if (source) {
+            source->addEdges[type] = target;
+        }
+    }
+
+    moveEntity(entity, location, target, getWriteVersion());
+    return target->getComponent(type, location.slot);
+}
+
+void ComponentManager::removeComponent(Entity entity, ComponentTypeID type) {
+    EntityLocation* location = findLocation(entity);
+    if (!location || !location->archetype || !location->archetype->hasComponent(type)) {
+        return;
+    }
+
+    Archetype* source = location->archetype;
+    Archetype* target = source->removeEdges[type];
+    if (!target) {
+        target = getOrCreateArchetype(ComponentMask{source->getMask()}.reset(type));
+        source->removeEdges[type] = target;
+    }
+    moveEntity(entity, *location, target, getWriteVersion());
+}
+
+void* ComponentManager::getComponent(Entity entity, ComponentTypeID type) {
+    EntityLocation* location = findLocation(entity);
+    if (!location || !location->archetype || !location->archetype->hasComponent(type)) {
+        return nullptr;
+    }
+    location->archetype->markColumnChanged(type, location->slot, getWriteVersion());
+    return location->archetype->getComponent(type, location->slot);
+}
+
+const void* ComponentManager::getComponent(Entity entity, ComponentTypeID type) const {
+    const EntityLocation* location = getLocation(entity);
+    if (!location || !location->archetype || !location->archetype->hasComponent(type)) {
+        return nullptr;
+    }
+    return location->archetype->getComponent(type, location->slot);
+}
+
+bool ComponentManager::hasComponent(Entity entity, ComponentTypeID type) const {
+    const EntityLocation* location = getLocation(entity);
+    return location && location->archetype && location->archetype->hasComponent(type);
+}
+
+void ComponentManager::removeEntity(Entity entity) {
+    if (EntityLocation* location = findLocation(entity)) {
+        moveEntity(entity, *location, nullptr, getWriteVersion());
+    }
+}
+
+void ComponentManager::clear() {
+    const size_t reserved = levelArena.getReservedBytes();
+    queryCaches.clear();
+    archetypeByMask.clear();
+    archetypes.clear();
+    locations.clear();
+    chunkPool.reset();
+    levelArena.reset();
+    levelGeneration++;
+    componentLogger.debug("Cleared level, keeping {} KB of chunk pages", reserved / 1024);
+}
+
+void ComponentManager::moveEntities(Archetype* source, const ComponentMask& targetMask, std::span<const Entity> entities) {
+    Archetype* target = getOrCreateArchetype(targetMask);
+    if (entities.empty() || source == target) {
+        return;
+    }
+
+    const ChangeVersion version = getWriteVersion();
+    struct Move {
+        Entity entity;
+        uint32_t sourceSlot;
+    };
+    std::vector<Move> moves;
+    moves.reserve(entities.size());
+    for (const Entity& entity : entities) {
+        if (entity.id >= locations.size()) {
+            locations.resize(entity.id + 1);
+        }
+        EntityLocation& location = locations[entity.id];
+        if (!source) {
+            if (location.archetype && location.generation != entity.generation) {
+                // Same as addComponent: the recycled id's previous owner still has a row to drop.
+                moveEntity(NullEntity, location, nullptr, version);
+            }
+            location.generation = entity.generation;
+        }
+        moves.emplace_back(Move{entity, location.slot});
+    }
+    if (source) {
+        std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) { return a.sourceSlot < b.sourceSlot; });
+    }
+
+    if (target) {
+        std::vector<Entity> sorted;
+        sorted.reserve(moves.size());
+        for (const Move& move : moves) {
+            sorted.emplace_back(move.entity);
+        }
+        const uint32_t firstSlot = target->addRows(sorted, version);
+
+        if (source) {
+            const uint32_t sourceCapacity = source->getChunkCapacity();
+            const uint32_t targetCapacity = target->getChunkCapacity();
+            for (ComponentTypeID type : source->getTypes()) {
+                if (!target->hasComponent(type)) {
+                    continue;
+                }
+                const size_t size = getComponentInfo(type).size;
+                // Extend a run while source and target rows stay consecutive inside one chunk each.
+                for (size_t begin = 0; begin < moves.size();) {
+                    size_t end = begin + 1;
+                    while (end < moves.size()
+                        && moves[end].sourceSlot == moves[end - 1].sourceSlot + 1
+                        && moves[end].sourceSlot % sourceCapacity != 0
+                        && (firstSlot + end) % targetCapacity != 0) {
+                        end++;
+                    }
+                    std::memcpy(
+                        target->getComponent(type, firstSlot + static_cast<uint32_t>(begin)),
+                        source->getComponent(type, moves[begin].sourceSlot),
+                        size * (end - begin)
+                    );
+                    begin = end;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            EntityLocation& location = locations[moves[i].entity.id];
+            location.archetype = target;
+            location.slot = firstSlot + static_cast<uint32_t>(i);
+        }
+    } else {
+        for (const Move& move : moves) {
+            locations[move.entity.id].archetype = nullptr;
+        }
+    }
+
+    if (source) {
+        // Highest slot first: the row swapped into a hole is never one that still has to leave, and when a
+        // whole tail moves no row is copied at all.
+        for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+            const Entity moved = source->removeRow(it->sourceSlot, version);
+            if (moved != NullEntity) {
+                locations[moved.id].slot = it->sourceSlot;
+            }
+        }
+    }
+}
+
+const std::vector<Archetype*>& ComponentManager::queryArchetypes(const ComponentMask& required) {
+    QueryCache& cache = queryCaches[required];
+    for (; cache.archetypesSeen < archetypes.size(); cache.archetypesSeen++) {
+        Archetype* archetype = archetypes[cache.archetypesSeen].get();
+        if ((archetype->getMask() & required) == required) {
+            cache.archetypes.emplace_back(archetype);
+        }
+    }
+    return cache.archetypes;
+}
+
 }
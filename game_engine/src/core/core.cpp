@@ -6,7 +6,7 @@ namespace Core {
 
 Core::Core() 
     : coreLogger{Utils::initLogger("Core", spdlog::level::debug)} {
-    coreLogger.debug("Core Initialized");
+    coreLogger.debug("Core Initialized with {} job threads", jobSystem.getThreadCount());
 }
 
 Core::~Core() {
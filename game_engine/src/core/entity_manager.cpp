@@ -1,11 +1,97 @@
 #include "core/entity_manager.hpp"
 #include <spdlog/spdlog.h>
 #include "utils/utils.hpp"
+#include <cassert>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ENGINE_TARGET_AVX2
+#else
+#define ENGINE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace {
+
+constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+void integrateAxisScalar(float* position, float* velocity, const float* acceleration, size_t count, float deltaTime) {
+    for (size_t i = 0; i < count; i++) {
+        velocity[i] += acceleration[i] * deltaTime;
+        position[i] += velocity[i] * deltaTime;
+    }
+}
+
+void integrateAxisSSE(float* position, float* velocity, const float* acceleration, size_t count, float deltaTime) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(velocity + i), _mm_mul_ps(_mm_loadu_ps(acceleration + i), dt));
+        __m128 p = _mm_add_ps(_mm_loadu_ps(position + i), _mm_mul_ps(v, dt));
+        _mm_storeu_ps(velocity + i, v);
+        _mm_storeu_ps(position + i, p);
+    }
+    integrateAxisScalar(position + i, velocity + i, acceleration + i, count - i, deltaTime);
+}
+
+ENGINE_TARGET_AVX2
+void integrateAxisAVX2(float* position, float* velocity, const float* acceleration, size_t count, float deltaTime) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    size_t i = 0;
+    // Two independent registers per iteration to hide the FMA latency.
+    for (; i + 16 <= count; i += 16) {
+        __m256 v0 = _mm256_fmadd_ps(_mm256_loadu_ps(acceleration + i), dt, _mm256_loadu_ps(velocity + i));
+        __m256 v1 = _mm256_fmadd_ps(_mm256_loadu_ps(acceleration + i + 8), dt, _mm256_loadu_ps(velocity + i + 8));
+        __m256 p0 = _mm256_fmadd_ps(v0, dt, _mm256_loadu_ps(position + i));
+        __m256 p1 = _mm256_fmadd_ps(v1, dt, _mm256_loadu_ps(position + i + 8));
+        _mm256_storeu_ps(velocity + i, v0);
+        _mm256_storeu_ps(velocity + i + 8, v1);
+        _mm256_storeu_ps(position + i, p0);
+        _mm256_storeu_ps(position + i + 8, p1);
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_fmadd_ps(_mm256_loadu_ps(acceleration + i), dt, _mm256_loadu_ps(velocity + i));
+        __m256 p = _mm256_fmadd_ps(v, dt, _mm256_loadu_ps(position + i));
+        _mm256_storeu_ps(velocity + i, v);
+        _mm256_storeu_ps(position + i, p);
+    }
+    integrateAxisScalar(position + i, velocity + i, acceleration + i, count - i, deltaTime);
+}
+
+bool cpuSupportsAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+Core::IntegrateAxisFn selectIntegrator(spdlog::logger& logger) {
+    if (cpuSupportsAVX2()) {
+        logger.debug("Using AVX2 entity integrator");
+        return integrateAxisAVX2;
+    }
+    logger.debug("Using SSE entity integrator");
+    return integrateAxisSSE;
+}
+
+}
 
 namespace Core {
 
-EntityManager::EntityManager() 
+EntityManager::EntityManager()
     : entityLogger{Utils::initLogger("Entity", spdlog::level::debug)} {
+    integrateAxis = selectIntegrator(entityLogger);
+    denseIndices.emplace_back(InvalidIndex);
+    generations.emplace_back(0);
     entityLogger.debug("Entity Manager Initialized");
 }
 
@@ -13,29 +99,131 @@ EntityManager::~EntityManager() {
     entityLogger.debug("Entity Manager Shutdown");
 }
 
+std::array<std::vector<float>*, 12> EntityManager::streams() {
+    return {
+        &positionX, &positionY, &positionZ,
+        &velocityX, &velocityY, &velocityZ,
+        &accelerationX, &accelerationY, &accelerationZ,
+        &rotationX, &rotationY, &rotationZ
+    };
+}
+
+void EntityManager::reserve(size_t count) {
+    entities.reserve(count);
+    for (auto* stream : streams()) {
+        stream->reserve(count);
+    }
+}
+
+Entity EntityManager::addEntity() {
+    uint32_t id;
+    if (!freeIDs.empty()) {
+        id = freeIDs.back();
+        freeIDs.pop_back();
+    } else {
+        id = nextEntityID++;
+        denseIndices.emplace_back(InvalidIndex);
+        generations.emplace_back(0);
+    }
 
-void EntityManager::addEntity(const Entity& entity) {
+    const Entity entity{id, generations[id]};
+    denseIndices[id] = static_cast<uint32_t>(entities.size());
     entities.emplace_back(entity);
+    for (auto* stream : streams()) {
+        stream->emplace_back(0.0f);
+    }
+    return entity;
 }
 
-void EntityManager::removeEntity(unsigned int id) {
-    entities.erase(entities.begin() + id);
+void EntityManager::removeEntity(Entity entity) {
+    if (!isAlive(entity)) {
+        entityLogger.warn("Tried to remove stale entity {} (generation {})", entity.id, entity.generation);
+        return;
+    }
+
+    // Swap-and-pop: move the last entity into the hole so the dense arrays stay contiguous.
+    const uint32_t index = denseIndices[entity.id];
+    const uint32_t last = static_cast<uint32_t>(entities.size() - 1);
+    if (index != last) {
+        const Entity moved = entities[last];
+        entities[index] = moved;
+        denseIndices[moved.id] = index;
+        for (auto* stream : streams()) {
+            (*stream)[index] = (*stream)[last];
+        }
+    }
+    entities.pop_back();
+    for (auto* stream : streams()) {
+        stream->pop_back();
+    }
+
+    denseIndices[entity.id] = InvalidIndex;
+    generations[entity.id]++;
+    freeIDs.emplace_back(entity.id);
 }
 
-void EntityManager::updateEntities(float deltaTime){
-    for (auto& entity : entities) {
-        // entity.positionX += entity.velocityX * deltaTime;
-        // entity.positionY += entity.velocityY * deltaTime;
-        // entity.positionZ += entity.velocityZ * deltaTime;
+void EntityManager::removeEntities(std::span<const Entity> toRemove) {
+    for (const auto& entity : toRemove) {
+        removeEntity(entity);
     }
 }
 
+void EntityManager::updateEntities(float deltaTime) {
+    const size_t count = entities.size();
+    integrateAxis(positionX.data(), velocityX.data(), accelerationX.data(), count, deltaTime);
+    integrateAxis(positionY.data(), velocityY.data(), accelerationY.data(), count, deltaTime);
+    integrateAxis(positionZ.data(), velocityZ.data(), accelerationZ.data(), count, deltaTime);
+}
+
 const std::vector<Entity>& EntityManager::getEntities() const {
     return entities;
 }
 
-Entity& EntityManager::getEntity(unsigned int id) {
-    return entities[id];
+Entity EntityManager::getEntity(uint32_t id) const {
+    if (id == 0 || id >= denseIndices.size() || denseIndices[id] == InvalidIndex) {
+        return NullEntity;
+    }
+    return entities[denseIndices[id]];
+}
+
+bool EntityManager::isAlive(Entity entity) const {
+    return entity.id != 0
+        && entity.id < generations.size()
+        && generations[entity.id] == entity.generation
+        && denseIndices[entity.id] != InvalidIndex;
+}
+
+uint32_t EntityManager::getIndex(Entity entity) const {
+    assert(isAlive(entity));
+    return denseIndices[entity.id];
+}
+
+void EntityManager::setPosition(Entity entity, float x, float y, float z) {
+    const uint32_t id = getIndex(entity);
+    positionX[id] = x;
+    positionY[id] = y;
+    positionZ[id] = z;
+}
+
+void EntityManager::setVelocity(Entity entity, float x, float y, float z) {
+    const uint32_t id = getIndex(entity);
+    velocityX[id] = x;
+    velocityY[id] = y;
+    velocityZ[id] = z;
+}
+
+void EntityManager::setAcceleration(Entity entity, float x, float y, float z) {
+    const uint32_t id = getIndex(entity);
+    accelerationX[id] = x;
+    accelerationY[id] = y;
+    accelerationZ[id] = z;
+}
+
+void EntityManager::setRotation(Entity entity, float x, float y, float z) {
+    const uint32_t id = getIndex(entity);
+    rotationX[id] = x;
+    rotationY[id] = y;
+    rotationZ[id] = z;
 }
 
 }
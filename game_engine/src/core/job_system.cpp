@@ -0,0 +1,198 @@
+#include "core/job_system.hpp"
+
+namespace {
+
+constexpr size_t NoDeque = static_cast<size_t>(-1);
+constexpr int SpinsBeforeSleep = 64;
+
+thread_local const Core::JobSystem* currentJobSystem = nullptr;
+thread_local size_t currentDequeIndex = NoDeque;
+
+}
+
+namespace Core {
+
+WorkStealingDeque::WorkStealingDeque()
+    : buffer{std::make_unique<std::atomic<Job*>[]>(Capacity)} {
+}
+
+bool WorkStealingDeque::push(Job* job) {
+    const int64_t b = bottom.load(std::memory_order_relaxed);
+    const int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= Capacity) {
+        return false;
+    }
+    buffer[b & (Capacity - 1)].store(job, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingDeque::pop() {
+    const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last element: race the thieves for it.
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Job* job = buffer[t & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(size_t workerCount) {
+    for (size_t i = 0; i < workerCount + 1; i++) {
+        deques.emplace_back(std::make_unique<WorkStealingDeque>());
+    }
+    currentJobSystem = this;
+    currentDequeIndex = 0;
+    for (size_t i = 1; i <= workerCount; i++) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    stopping.store(true);
+    {
+        std::scoped_lock lock(sleepMutex);
+    }
+    sleepCondition.notify_all();
+    workers.clear();
+
+    // Finish anything still queued so no counter is left waiting forever.
+    while (Job* job = findJob(currentJobSystem == this ? currentDequeIndex : NoDeque)) {
+        execute(job);
+    }
+    if (currentJobSystem == this) {
+        currentJobSystem = nullptr;
+        currentDequeIndex = NoDeque;
+    }
+}
+
+void JobSystem::submit(std::function<void()> task, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    enqueue(new Job{std::move(task), counter});
+}
+
+void JobSystem::enqueue(Job* job) {
+    // Count the job before publishing it, otherwise a thief can take it and decrement first, wrapping
+    // queuedJobs and keeping every worker awake until the increment lands.
+    queuedJobs.fetch_add(1);
+    const bool ownsDeque = currentJobSystem == this && currentDequeIndex != NoDeque;
+    if (!ownsDeque || !deques[currentDequeIndex]->push(job)) {
+        std::scoped_lock lock(injectionMutex);
+        injectionQueue.emplace_back(job);
+    }
+    wakeWorker();
+}
+
+void JobSystem::wakeWorker() {
+    if (sleepingWorkers.load() > 0) {
+        // Taking the lock orders this wake-up after a worker's final check of queuedJobs.
+        std::scoped_lock lock(sleepMutex);
+        sleepCondition.notify_one();
+    }
+}
+
+Job* JobSystem::findJob(size_t thiefIndex) {
+    Job* job = nullptr;
+    if (thiefIndex != NoDeque) {
+        job = deques[thiefIndex]->pop();
+    }
+    if (!job) {
+        std::scoped_lock lock(injectionMutex);
+        if (!injectionQueue.empty()) {
+            job = injectionQueue.front();
+            injectionQueue.pop_front();
+        }
+    }
+    if (!job) {
+        const size_t count = deques.size();
+        const size_t start = thiefIndex == NoDeque ? 0 : thiefIndex + 1;
+        for (size_t i = 0; i < count && !job; i++) {
+            const size_t victim = (start + i) % count;
+            if (victim != thiefIndex) {
+                job = deques[victim]->steal();
+            }
+        }
+    }
+    if (job) {
+        queuedJobs.fetch_sub(1);
+    }
+    return job;
+}
+
+void JobSystem::execute(Job* job) {
+    job->task();
+    if (job->counter) {
+        job->counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+    delete job;
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const size_t index = currentJobSystem == this ? currentDequeIndex : NoDeque;
+    while (!counter.isDone()) {
+        if (Job* job = findJob(index)) {
+            execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+size_t JobSystem::getThreadIndex() const {
+    return currentJobSystem == this && currentDequeIndex != NoDeque ? currentDequeIndex : deques.size();
+}
+
+void JobSystem::workerLoop(size_t index) {
+    currentJobSystem = this;
+    currentDequeIndex = index;
+
+    int spins = 0;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (Job* job = findJob(index)) {
+            execute(job);
+            spins = 0;
+            continue;
+        }
+        if (++spins < SpinsBeforeSleep) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        sleepingWorkers.fetch_add(1);
+        sleepCondition.wait(lock, [this] { return stopping.load() || queuedJobs.load() > 0; });
+        sleepingWorkers.fetch_sub(1);
+        spins = 0;
+    }
+}
+
+}
@@ -0,0 +1,106 @@
+#include "core/memory_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace {
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+namespace Core {
+
+MemoryArena::MemoryArena(size_t pageSize)
+    : pageSize{pageSize} {
+}
+
+MemoryArena::~MemoryArena() {
+    for (const Page& page : pages) {
+        ::operator delete(page.data, std::align_val_t{ArenaPageAlignment});
+    }
+}
+
+MemoryArena::Page& MemoryArena::allocatePage(size_t size, size_t position) {
+    auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t{ArenaPageAlignment}));
+    return *pages.insert(pages.begin() + position, Page{data, size});
+}
+
+void* MemoryArena::allocate(size_t size, size_t alignment) {
+    auto alignedOffset = [alignment](const Page& page, size_t from) {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(page.data) + from;
+        return from + (alignUp(address, alignment) - address);
+    };
+
+    if (!pages.empty()) {
+        const size_t start = alignedOffset(pages[currentPage], offset);
+        if (start + size <= pages[currentPage].size) {
+            offset = start + size;
+            return pages[currentPage].data + start;
+        }
+    }
+
+    // Pages past the current one are unused, so the first one large enough becomes the next page.
+    const size_t padding = alignment > ArenaPageAlignment ? alignment : 0;
+    const size_t first = pages.empty() ? 0 : currentPage + 1;
+    size_t next = first;
+    while (next < pages.size() && pages[next].size < size + padding) {
+        next++;
+    }
+    if (next == pages.size()) {
+        allocatePage(std::max(pageSize, size + padding), first);
+    } else if (next != first) {
+        std::rotate(pages.begin() + first, pages.begin() + next, pages.begin() + next + 1);
+    }
+
+    currentPage = first;
+    const size_t start = alignedOffset(pages[currentPage], 0);
+    offset = start + size;
+    return pages[currentPage].data + start;
+}
+
+void MemoryArena::rewind(ArenaMarker marker) {
+    currentPage = marker.page;
+    offset = marker.offset;
+}
+
+size_t MemoryArena::getUsedBytes() const {
+    size_t used = offset;
+    for (size_t page = 0; page < currentPage && page < pages.size(); page++) {
+        used += pages[page].size;
+    }
+    return used;
+}
+
+size_t MemoryArena::getReservedBytes() const {
+    size_t reserved = 0;
+    for (const Page& page : pages) {
+        reserved += page.size;
+    }
+    return reserved;
+}
+
+BlockPool::BlockPool(MemoryArena& arena, size_t blockSize, size_t blockAlignment)
+    : arena{arena}, blockSize{blockSize}, blockAlignment{blockAlignment} {
+}
+
+std::byte* BlockPool::acquire() {
+    if (!freeBlocks.empty()) {
+        std::byte* block = freeBlocks.back();
+        freeBlocks.pop_back();
+        return block;
+    }
+    return static_cast<std::byte*>(arena.allocate(blockSize, blockAlignment));
+}
+
+void BlockPool::release(std::byte* block) {
+    freeBlocks.emplace_back(block);
+}
+
+void BlockPool::reset() {
+    freeBlocks.clear();
+}
+
+}
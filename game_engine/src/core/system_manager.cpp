@@ -4,8 +4,9 @@
 
 namespace Core {
 
-SystemManager::SystemManager()
-    : systemLogger{Utils::initLogger("SystemLogger", spdlog::level::debug)} {
+SystemManager::SystemManager(JobSystem& jobSystem)
+    : systemLogger{Utils::initLogger("SystemLogger", spdlog::level::debug)},
+      jobSystem{jobSystem} {
         systemLogger.debug("System Manager Initialized");
 }
 
@@ -13,4 +14,78 @@ SystemManager::~SystemManager() {
     systemLogger.debug("System Manager Shutdown");
 }
 
+SystemID SystemManager::addSystem(std::string name, SystemAccess access, SystemFn update) {
+    systemLogger.debug("Registered system '{}'", name);
+    systems.emplace_back(SystemNode{
+        .name = std::move(name),
+        .access = access,
+        .update = std::move(update),
+        .dependents = {}
+    });
+    graphDirty = true;
+    return static_cast<SystemID>(systems.size() - 1);
+}
+
+void SystemManager::buildGraph() {
+    for (auto& system : systems) {
+        system.dependents.clear();
+        system.dependencyCount = 0;
+    }
+
+    // Only the nearest earlier conflicting system needs an edge per component, but an edge to every
+    // earlier conflict is simpler and the system count is small.
+    for (SystemID later = 0; later < systems.size(); later++) {
+        for (SystemID earlier = 0; earlier < later; earlier++) {
+            if (systems[earlier].access.conflictsWith(systems[later].access)) {
+                systems[earlier].dependents.emplace_back(later);
+                systems[later].dependencyCount++;
+            }
+        }
+    }
+    graphDirty = false;
+}
+
+void SystemManager::runSystem(SystemID id) {
+    try {
+        systems[id].update(frameDeltaTime);
+    } catch (...) {
+        std::scoped_lock lock(exceptionMutex);
+        if (!frameException) {
+            frameException = std::current_exception();
+        }
+    }
+
+    // Dependents are submitted before this job retires, so the frame counter never hits zero early.
+    for (SystemID dependent : systems[id].dependents) {
+        if (systems[dependent].pendingDependencies->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            jobSystem.submit([this, dependent] { runSystem(dependent); }, &frameCounter);
+        }
+    }
+}
+
+void SystemManager::update(float deltaTime) {
+    if (systems.empty()) {
+        return;
+    }
+    if (graphDirty) {
+        buildGraph();
+    }
+
+    frameDeltaTime = deltaTime;
+    frameException = nullptr;
+    for (auto& system : systems) {
+        system.pendingDependencies->store(system.dependencyCount, std::memory_order_relaxed);
+    }
+    for (SystemID id = 0; id < systems.size(); id++) {
+        if (systems[id].dependencyCount == 0) {
+            jobSystem.submit([this, id] { runSystem(id); }, &frameCounter);
+        }
+    }
+    jobSystem.wait(frameCounter);
+
+    if (frameException) {
+        std::rethrow_exception(frameException);
+    }
+}
+
 }
@@ -0,0 +1,274 @@
+#include "core/transform_hierarchy.hpp"
+#include "utils/utils.hpp"
+#include <cassert>
+#include <limits>
+
+namespace {
+
+constexpr uint32_t InvalidNode = std::numeric_limits<uint32_t>::max();
+
+template<typename T>
+void gather(std::vector<T>& stream, const std::vector<uint32_t>& order) {
+    std::vector<T> sorted;
+    sorted.reserve(order.size());
+    for (const uint32_t node : order) {
+        sorted.push_back(stream[node]);
+    }
+    stream.swap(sorted);
+}
+
+}
+
+namespace Core {
+
+TransformHierarchy::TransformHierarchy()
+    : transformLogger{Utils::initLogger("Transform", spdlog::level::debug)} {
+    transformLogger.debug("Transform Hierarchy Initialized");
+}
+
+TransformHierarchy::~TransformHierarchy() {
+    transformLogger.debug("Transform Hierarchy Shutdown");
+}
+
+// Leaves a hole that rebuildLayout closes. A recycled id may already own a newer node, which keeps it.
+void TransformHierarchy::dropNode(uint32_t node) {
+    if (nodeOf[entities[node].id] == node) {
+        nodeOf[entities[node].id] = InvalidNode;
+    }
+    entities[node] = NullEntity;
+    layoutDirty = true;
+}
+
+// Parents always precede their children, even between rebuilds, so every pass here is a single sweep.
+void TransformHierarchy::rebuildLayout() {
+    const uint32_t count = size();
+    for (uint32_t node = 0; node < count; node++) {
+        if (entities[node] != NullEntity && parents[node] >= 0 && entities[parents[node]] == NullEntity) {
+            dropNode(node);
+        }
+    }
+
+    for (uint32_t node = 0; node < count; node++) {
+        subtreeSizes[node] = entities[node] != NullEntity ? 1 : 0;
+    }
+    for (uint32_t node = count; node-- > 0;) {
+        if (subtreeSizes[node] && parents[node] >= 0) {
+            subtreeSizes[parents[node]] += subtreeSizes[node];
+        }
+    }
+
+    // Roots and siblings keep their relative order; each child takes the next slot after its parent's
+    // earlier children.
+    newNodes.assign(count, InvalidNode);
+    nextChild.resize(count);
+    uint32_t nextRoot = 0;
+    for (uint32_t node = 0; node < count; node++) {
+        if (entities[node] == NullEntity) {
+            continue;
+        }
+        uint32_t& slot = parents[node] >= 0 ? nextChild[parents[node]] : nextRoot;
+        newNodes[node] = slot;
+        slot += subtreeSizes[node];
+        nextChild[node] = newNodes[node] + 1;
+    }
+
+    order.resize(nextRoot);
+    for (uint32_t node = 0; node < count; node++) {
+        if (newNodes[node] != InvalidNode) {
+            order[newNodes[node]] = node;
+        }
+    }
+
+    gather(entities, order);
+    gather(parents, order);
+    gather(subtreeSizes, order);
+    for (auto* stream : {&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ}) {
+        gather(*stream, order);
+    }
+    gather(localDirty, order);
+    gather(worldDirty, order);
+    gather(localMatrices, order);
+    gather(worldMatrices, order);
+
+    for (uint32_t node = 0; node < size(); node++) {
+        if (parents[node] >= 0) {
+            parents[node] = static_cast<int32_t>(newNodes[parents[node]]);
+        }
+        nodeOf[entities[node].id] = node;
+    }
+    layoutDirty = false;
+}
+
+uint32_t TransformHierarchy::findNode(Entity entity) const {
+    if (entity.id >= nodeOf.size() || nodeOf[entity.id] == InvalidNode) {
+        return InvalidNode;
+    }
+    const uint32_t node = nodeOf[entity.id];
+    return entities[node] == entity ? node : InvalidNode;
+}
+
+bool TransformHierarchy::contains(Entity entity) const {
+    return findNode(entity) != InvalidNode;
+}
+
+void TransformHierarchy::addNode(Entity entity, Entity parent) {
+    if (contains(entity)) {
+        transformLogger.warn("Entity {} is already in the transform hierarchy", entity.id);
+        return;
+    }
+    if (entity.id >= nodeOf.size()) {
+        nodeOf.resize(entity.id + 1, InvalidNode);
+    }
+
+    const uint32_t parentNode = parent == NullEntity ? InvalidNode : findNode(parent);
+    if (parent != NullEntity && parentNode == InvalidNode) {
+        transformLogger.warn("Parent {} of entity {} is not in the transform hierarchy", parent.id, entity.id);
+        return;
+    }
+
+    // Appending keeps parents ahead of children; a child is moved into its parent's subtree by the next
+    // rebuildLayout.
+    nodeOf[entity.id] = size();
+    entities.push_back(entity);
+    parents.push_back(parentNode == InvalidNode ? -1 : static_cast<int32_t>(parentNode));
+    subtreeSizes.push_back(1);
+    for (auto* stream : {&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ}) {
+        stream->push_back(0.0f);
+    }
+    for (auto* stream : {&scaleX, &scaleY, &scaleZ}) {
+        stream->push_back(1.0f);
+    }
+    localDirty.push_back(1);
+    worldDirty.push_back(1);
+    localMatrices.push_back(Engine::Mat4::identity());
+    worldMatrices.push_back(Engine::Mat4::identity());
+    if (parentNode != InvalidNode) {
+        layoutDirty = true;
+    }
+}
+
+void TransformHierarchy::removeNode(Entity entity) {
+    const uint32_t node = findNode(entity);
+    if (node == InvalidNode) {
+        return;
+    }
+    dropNode(node);
+}
+
+void TransformHierarchy::setScale(Entity entity, float x, float y, float z) {
+    const uint32_t node = findNode(entity);
+    assert(node != InvalidNode);
+    scaleX[node] = x;
+    scaleY[node] = y;
+    scaleZ[node] = z;
+    localDirty[node] = 1;
+}
+
+void TransformHierarchy::syncFromEntities(const EntityManager& entityManager) {
+    const auto& sourcePositionX = entityManager.getPositionX();
+    const auto& sourcePositionY = entityManager.getPositionY();
+    const auto& sourcePositionZ = entityManager.getPositionZ();
+    const auto& sourceRotationX = entityManager.getRotationX();
+    const auto& sourceRotationY = entityManager.getRotationY();
+    const auto& sourceRotationZ = entityManager.getRotationZ();
+
+    for (uint32_t node = 0; node < entities.size(); node++) {
+        if (entities[node] == NullEntity) {
+            continue;
+        }
+        // Catches every way an entity can be destroyed, so nodes never outlive their entities.
+        if (!entityManager.isAlive(entities[node])) {
+            dropNode(node);
+            continue;
+        }
+        const uint32_t index = entityManager.getIndex(entities[node]);
+        if (positionX[node] != sourcePositionX[index] || positionY[node] != sourcePositionY[index]
+            || positionZ[node] != sourcePositionZ[index] || rotationX[node] != sourceRotationX[index]
+            || rotationY[node] != sourceRotationY[index] || rotationZ[node] != sourceRotationZ[index]) {
+            positionX[node] = sourcePositionX[index];
+            positionY[node] = sourcePositionY[index];
+            positionZ[node] = sourcePositionZ[index];
+            rotationX[node] = sourceRotationX[index];
+            rotationY[node] = sourceRotationY[index];
+            rotationZ[node] = sourceRotationZ[index];
+            localDirty[node] = 1;
+        }
+    }
+}
+
+void TransformHierarchy::update() {
+    if (layoutDirty) {
+        rebuildLayout();
+    }
+    changedNodes.clear();
+    const uint32_t count = size();
+
+    // Recompose local matrices in runs of consecutive dirty nodes.
+    for (uint32_t begin = 0; begin < count;) {
+        if (!localDirty[begin]) {
+            begin++;
+            continue;
+        }
+        uint32_t end = begin + 1;
+        while (end < count && localDirty[end]) {
+            end++;
+        }
+        Engine::composeTransforms(
+            positionX.data() + begin, positionY.data() + begin, positionZ.data() + begin,
+            rotationX.data() + begin, rotationY.data() + begin, rotationZ.data() + begin,
+            scaleX.data() + begin, scaleY.data() + begin, scaleZ.data() + begin,
+            end - begin, localMatrices.data() + begin
+        );
+        begin = end;
+    }
+
+    // Parents precede children, so a single forward pass sees every ancestor's final world matrix.
+    for (uint32_t node = 0; node < count; node++) {
+        const int32_t parent = parents[node];
+        const bool dirty = localDirty[node] || worldDirty[node] || (parent >= 0 && worldDirty[parent]);
+        localDirty[node] = 0;
+        worldDirty[node] = dirty;
+        if (!dirty) {
+            continue;
+        }
+        if (parent >= 0) {
+            Engine::multiply(worldMatrices[parent], localMatrices[node], worldMatrices[node]);
+        } else {
+            worldMatrices[node] = localMatrices[node];
+        }
+        changedNodes.emplace_back(node);
+    }
+
+    for (const uint32_t node : changedNodes) {
+        worldDirty[node] = 0;
+    }
+}
+
+void TransformHierarchy::writeWorldTransforms(ComponentManager& componentManager) {
+    const ComponentTypeID type = componentTypeID<WorldTransform>();
+    // Entities that moved last time but not this time have to stop interpolating.
+    for (const Entity entity : writtenEntities) {
+        if (componentManager.hasComponent(entity, type)) {
+            WorldTransform* transform = static_cast<WorldTransform*>(componentManager.getComponent(entity, type));
+            transform->previous = transform->matrix;
+        }
+    }
+
+    writtenEntities.clear();
+    for (const uint32_t node : changedNodes) {
+        if (componentManager.hasComponent(entities[node], type)) {
+            WorldTransform* transform = static_cast<WorldTransform*>(componentManager.getComponent(entities[node], type));
+            transform->previous = transform->matrix;
+            transform->matrix = worldMatrices[node];
+            writtenEntities.push_back(entities[node]);
+        }
+    }
+}
+
+const Engine::Mat4& TransformHierarchy::getWorldMatrix(Entity entity) const {
+    const uint32_t node = findNode(entity);
+    assert(node != InvalidNode);
+    return worldMatrices[node];
+}
+
+}
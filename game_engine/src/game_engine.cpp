@@ -17,19 +17,37 @@ GameEngine::~GameEngine() {
 }
 
 void GameEngine::shutdown() {
+    transformHierarchy.reset();
+    frameArena.reset();
+    entityCommands.reset();
     systemManager.reset();
     entityManager.reset();
     componentManager.reset();
     sceneManager.reset();
     resourceManager.reset();
+    coreSystems.reset();
 }
 
 void GameEngine::initialize() {
-    systemManager = std::move(std::make_unique<Core::SystemManager>());
+    coreSystems = std::move(std::make_unique<Core::Core>());
+    systemManager = std::move(std::make_unique<Core::SystemManager>(coreSystems->getJobSystem()));
     entityManager = std::move(std::make_unique<Core::EntityManager>());
     componentManager = std::move(std::make_unique<Core::ComponentManager>());
     sceneManager = std::move(std::make_unique<Core::SceneManager>());
     resourceManager = std::move(std::make_unique<Core::ResourceManager>());
+    entityCommands = std::move(std::make_unique<Core::EntityCommandQueue>());
+    transformHierarchy = std::move(std::make_unique<Core::TransformHierarchy>());
+    frameArena = std::move(std::make_unique<Core::MemoryArena>());
+}
+
+void GameEngine::update(float deltaTime) {
+    frameArena->reset();
+    entityManager->updateEntities(deltaTime);
+    systemManager->update(deltaTime);
+    entityCommands->playback(*entityManager, *componentManager, *frameArena);
+    transformHierarchy->syncFromEntities(*entityManager);
+    transformHierarchy->update();
+    transformHierarchy->writeWorldTransforms(*componentManager);
 }
 
 }
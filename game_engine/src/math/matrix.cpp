@@ -0,0 +1,147 @@
+#include "math/matrix.hpp"
+#include <cmath>
+#include <immintrin.h>
+
+namespace {
+
+// Cephes single precision sine and cosine of four angles at once: reduce to [-pi/4, pi/4] around the
+// nearest multiple of pi/4, evaluate both minimax polynomials and pick per lane by octant.
+void sinCos(__m128 x, __m128& sine, __m128& cosine) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+    __m128 sineSign = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    const __m128 y = _mm_cvtepi32_ps(octant);
+
+    sineSign = _mm_xor_ps(sineSign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+    const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+    const __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+    const __m128 z = _mm_mul_ps(x, x);
+
+    __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+    cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+    cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+    __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+    sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly)), sineSign);
+    cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly)), cosineSign);
+}
+
+// Transposes four SoA columns, element by element across four transforms, into the matching column of
+// each of the four matrices.
+void storeColumns(__m128 e0, __m128 e1, __m128 e2, __m128 e3, Engine::Mat4* out, int column) {
+    _MM_TRANSPOSE4_PS(e0, e1, e2, e3);
+    _mm_store_ps(out[0].m + column * 4, e0);
+    _mm_store_ps(out[1].m + column * 4, e1);
+    _mm_store_ps(out[2].m + column * 4, e2);
+    _mm_store_ps(out[3].m + column * 4, e3);
+}
+
+}
+
+namespace Engine {
+
+Mat4 Mat4::identity() {
+    return Mat4{{
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    }};
+}
+
+void multiply(const Mat4& a, const Mat4& b, Mat4& out) {
+    const __m128 a0 = _mm_load_ps(a.m + 0);
+    const __m128 a1 = _mm_load_ps(a.m + 4);
+    const __m128 a2 = _mm_load_ps(a.m + 8);
+    const __m128 a3 = _mm_load_ps(a.m + 12);
+    for (int column = 0; column < 4; column++) {
+        const float* b_column = b.m + column * 4;
+        __m128 result = _mm_mul_ps(a0, _mm_set1_ps(b_column[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b_column[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b_column[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b_column[3])));
+        _mm_store_ps(out.m + column * 4, result);
+    }
+}
+
+void composeTransforms(
+    const float* positionX, const float* positionY, const float* positionZ,
+    const float* rotationX, const float* rotationY, const float* rotationZ,
+    const float* scaleX, const float* scaleY, const float* scaleZ,
+    size_t count, Mat4* out
+) {
+    // Four transforms per iteration, one per SSE lane.
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sx, cx, sy, cy, sz, cz;
+        sinCos(_mm_loadu_ps(rotationX + i), sx, cx);
+        sinCos(_mm_loadu_ps(rotationY + i), sy, cy);
+        sinCos(_mm_loadu_ps(rotationZ + i), sz, cz);
+        const __m128 scaleX4 = _mm_loadu_ps(scaleX + i);
+        const __m128 scaleY4 = _mm_loadu_ps(scaleY + i);
+        const __m128 scaleZ4 = _mm_loadu_ps(scaleZ + i);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 sysx = _mm_mul_ps(sy, sx);
+        const __m128 sycx = _mm_mul_ps(sy, cx);
+
+        storeColumns(
+            _mm_mul_ps(_mm_mul_ps(cy, cz), scaleX4),
+            _mm_mul_ps(_mm_mul_ps(cy, sz), scaleX4),
+            _mm_mul_ps(_mm_sub_ps(zero, sy), scaleX4),
+            zero, out + i, 0);
+        storeColumns(
+            _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cz, sysx), _mm_mul_ps(sz, cx)), scaleY4),
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sz, sysx), _mm_mul_ps(cz, cx)), scaleY4),
+            _mm_mul_ps(_mm_mul_ps(cy, sx), scaleY4),
+            zero, out + i, 1);
+        storeColumns(
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cz, sycx), _mm_mul_ps(sz, sx)), scaleZ4),
+            _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sz, sycx), _mm_mul_ps(cz, sx)), scaleZ4),
+            _mm_mul_ps(_mm_mul_ps(cy, cx), scaleZ4),
+            zero, out + i, 2);
+        storeColumns(
+            _mm_loadu_ps(positionX + i), _mm_loadu_ps(positionY + i), _mm_loadu_ps(positionZ + i),
+            _mm_set1_ps(1.0f), out + i, 3);
+    }
+
+    for (; i < count; i++) {
+        const float cx = std::cos(rotationX[i]), sx = std::sin(rotationX[i]);
+        const float cy = std::cos(rotationY[i]), sy = std::sin(rotationY[i]);
+        const float cz = std::cos(rotationZ[i]), sz = std::sin(rotationZ[i]);
+
+        float* m = out[i].m;
+        m[0] = cy * cz * scaleX[i];
+        m[1] = cy * sz * scaleX[i];
+        m[2] = -sy * scaleX[i];
+        m[3] = 0.0f;
+        m[4] = (cz * sy * sx - sz * cx) * scaleY[i];
+        m[5] = (sz * sy * sx + cz * cx) * scaleY[i];
+        m[6] = cy * sx * scaleY[i];
+        m[7] = 0.0f;
+        m[8] = (cz * sy * cx + sz * sx) * scaleZ[i];
+        m[9] = (sz * sy * cx - cz * sx) * scaleZ[i];
+        m[10] = cy * cx * scaleZ[i];
+        m[11] = 0.0f;
+        m[12] = positionX[i];
+        m[13] = positionY[i];
+        m[14] = positionZ[i];
+        m[15] = 1.0f;
+    }
+}
+
+}
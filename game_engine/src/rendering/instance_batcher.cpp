@@ -0,0 +1,78 @@
+#include "rendering/instance_batcher.hpp"
+#include <algorithm>
+#include <cstring>
+#include "utils/utils.hpp"
+
+namespace Rendering {
+
+InstanceBatcher::InstanceBatcher(Core::ComponentManager& componentManager)
+    : batcherLogger{Utils::initLogger("InstanceBatcher", spdlog::level::debug)},
+      instances{componentManager} {
+    batcherLogger.debug("Instance Batcher Initialized");
+}
+
+InstanceBatcher::~InstanceBatcher() {
+    batcherLogger.debug("Instance Batcher Shutdown");
+}
+
+const std::vector<InstanceBatch>& InstanceBatcher::pack(std::span<InstanceData> out, float alpha) {
+    meshCursors.clear();
+    instances.forEachChunk([&](std::span<const Core::Entity>, std::span<const Core::WorldTransform>, std::span<const MeshInstance> meshes) {
+        for (const MeshInstance& instance : meshes) {
+            if (instance.mesh >= meshCursors.size()) {
+                meshCursors.resize(instance.mesh + 1, 0);
+            }
+            meshCursors[instance.mesh]++;
+        }
+    });
+
+    // Past out.size() the highest meshes lose their trailing instances; everything that fits is still drawn.
+    batches.clear();
+    meshEnds.resize(meshCursors.size());
+    const uint32_t capacity = static_cast<uint32_t>(out.size());
+    uint32_t first = 0;
+    uint32_t total = 0;
+    for (uint32_t mesh = 0; mesh < meshCursors.size(); mesh++) {
+        total += meshCursors[mesh];
+        const uint32_t count = std::min(meshCursors[mesh], capacity - first);
+        if (count > 0) {
+            batches.emplace_back(InstanceBatch{mesh, first, count});
+        }
+        meshCursors[mesh] = first;
+        first += count;
+        meshEnds[mesh] = first;
+    }
+    if (total > capacity && !truncated) {
+        batcherLogger.warn("Instance buffer holds {} instances but {} exist, drawing the first {}", capacity, total, capacity);
+    }
+    truncated = total > capacity;
+
+    instances.forEachChunk([&](std::span<const Core::Entity>, std::span<const Core::WorldTransform> transforms, std::span<const MeshInstance> meshes) {
+        for (size_t i = 0; i < meshes.size(); i++) {
+            uint32_t& cursor = meshCursors[meshes[i].mesh];
+            if (cursor == meshEnds[meshes[i].mesh]) {
+                continue;
+            }
+            // Blending the matrices element-wise skews rotations slightly, which is invisible for the
+            // small steps between two updates.
+            const float* current = transforms[i].matrix.m;
+            const float* previous = transforms[i].previous.m;
+            float m[16];
+            for (int element = 0; element < 16; element++) {
+                m[element] = previous[element] + (current[element] - previous[element]) * alpha;
+            }
+            InstanceData data{
+                .modelRows = {
+                    {m[0], m[4], m[8], m[12]},
+                    {m[1], m[5], m[9], m[13]},
+                    {m[2], m[6], m[10], m[14]}
+                },
+                .color = {meshes[i].color[0], meshes[i].color[1], meshes[i].color[2], meshes[i].color[3]}
+            };
+            std::memcpy(&out[cursor++], &data, sizeof(InstanceData));
+        }
+    });
+    return batches;
+}
+
+}
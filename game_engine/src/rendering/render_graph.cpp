@@ -0,0 +1,339 @@
+#include "rendering/render_graph.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <optional>
+#include "utils/utils.hpp"
+
+namespace {
+
+constexpr uint32_t NoPass = std::numeric_limits<uint32_t>::max();
+
+Rendering::TextureLayout layoutOf(Rendering::ResourceAccess access) {
+    using Rendering::ResourceAccess;
+    using Rendering::TextureLayout;
+    switch (access) {
+        case ResourceAccess::ColorAttachmentWrite: return TextureLayout::ColorAttachment;
+        case ResourceAccess::DepthAttachmentWrite: return TextureLayout::DepthAttachment;
+        case ResourceAccess::DepthAttachmentRead: return TextureLayout::DepthReadOnly;
+        case ResourceAccess::VertexShaderRead:
+        case ResourceAccess::FragmentShaderRead:
+        case ResourceAccess::ComputeShaderRead: return TextureLayout::ShaderReadOnly;
+        case ResourceAccess::ComputeShaderWrite: return TextureLayout::General;
+        case ResourceAccess::TransferRead: return TextureLayout::TransferSource;
+        case ResourceAccess::TransferWrite: return TextureLayout::TransferDestination;
+        case ResourceAccess::Present: return TextureLayout::Present;
+        default: return TextureLayout::Undefined;
+    }
+}
+
+bool overlaps(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB) {
+    return firstA <= lastB && firstB <= lastA;
+}
+
+}
+
+namespace Rendering {
+
+TextureLayout textureLayoutFor(AccessMask access) {
+    TextureLayout layout = TextureLayout::Undefined;
+    while (access != 0) {
+        const auto bit = static_cast<ResourceAccess>(std::countr_zero(access));
+        access &= access - 1;
+        const TextureLayout bitLayout = layoutOf(bit);
+        if (layout != TextureLayout::Undefined && bitLayout != layout) {
+            return TextureLayout::General;
+        }
+        layout = bitLayout;
+    }
+    return layout;
+}
+
+RenderGraph::RenderGraph()
+    : graphLogger{Utils::initLogger("RenderGraph", spdlog::level::debug)} {
+    graphLogger.debug("Render Graph Initialized");
+}
+
+RenderGraph::~RenderGraph() {
+    graphLogger.debug("Render Graph Shutdown");
+}
+
+void RenderGraph::reset() {
+    resources.clear();
+    passes.clear();
+    aliasSlots.clear();
+    finalBarriers.clear();
+}
+
+RenderResource RenderGraph::addResource(const Resource& resource) {
+    resources.emplace_back(resource);
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+RenderResource RenderGraph::importTexture(const char* name, const TextureDesc& desc, ResourceAccess current, bool discard) {
+    return addResource(Resource{
+        .name = name,
+        .type = RenderResourceType::Texture,
+        .imported = true,
+        .discard = discard,
+        .texture = desc,
+        .initialAccess = accessBit(current)
+    });
+}
+
+RenderResource RenderGraph::importBuffer(const char* name, uint64_t size, AccessMask current) {
+    return addResource(Resource{
+        .name = name,
+        .type = RenderResourceType::Buffer,
+        .imported = true,
+        .size = size,
+        .initialAccess = current
+    });
+}
+
+RenderResource RenderGraph::createTexture(const char* name, const TextureDesc& desc) {
+    return addResource(Resource{
+        .name = name,
+        .type = RenderResourceType::Texture,
+        .discard = true,
+        .texture = desc
+    });
+}
+
+RenderResource RenderGraph::createBuffer(const char* name, uint64_t size) {
+    return addResource(Resource{
+        .name = name,
+        .type = RenderResourceType::Buffer,
+        .discard = true,
+        .size = size
+    });
+}
+
+void RenderGraph::markOutput(RenderResource resource, ResourceAccess finalAccess) {
+    resources[resource].output = true;
+    resources[resource].finalAccess = accessBit(finalAccess);
+}
+
+RenderPassHandle RenderGraph::addPass(const char* name) {
+    passes.emplace_back(Pass{.name = name});
+    return static_cast<RenderPassHandle>(passes.size() - 1);
+}
+
+void RenderGraph::setSideEffects(RenderPassHandle pass) {
+    passes[pass].sideEffects = true;
+}
+
+void RenderGraph::access(RenderPassHandle pass, RenderResource resource, ResourceAccess access) {
+    assert(resource < resources.size());
+    resources[resource].usage |= accessBit(access);
+    for (PassAccess& existing : passes[pass].accesses) {
+        if (existing.resource == resource) {
+            existing.access |= accessBit(access);
+            return;
+        }
+    }
+    passes[pass].accesses.emplace_back(PassAccess{resource, accessBit(access)});
+}
+
+void RenderGraph::setMemoryRequirement(RenderResource resource, const MemoryRequirement& requirement) {
+    resources[resource].memory = requirement;
+}
+
+bool RenderGraph::isUsed(RenderResource resource) const {
+    return resources[resource].firstPass != NoPass;
+}
+
+void RenderGraph::compile() {
+    cullPasses();
+    computeLifetimes();
+    assignAliasSlots();
+    computeBarriers();
+}
+
+// Walks the passes backwards from the outputs. A pass survives if it has side effects or writes
+// something a surviving later pass or an output still needs; a pure write ends that need, since the
+// earlier contents are overwritten.
+void RenderGraph::cullPasses() {
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].output;
+    }
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        Pass& pass = passes[i];
+        bool live = pass.sideEffects;
+        for (const PassAccess& access : pass.accesses) {
+            live = live || ((access.access & WriteAccesses) && needed[access.resource]);
+        }
+        pass.culled = !live;
+        if (pass.culled) {
+            continue;
+        }
+        for (const PassAccess& access : pass.accesses) {
+            needed[access.resource] = (access.access & ~WriteAccesses) != 0;
+        }
+    }
+}
+
+void RenderGraph::computeLifetimes() {
+    for (Resource& resource : resources) {
+        resource.firstPass = NoPass;
+        resource.lastPass = NoPass;
+        resource.aliasSlot = -1;
+    }
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (passes[i].culled) {
+            continue;
+        }
+        for (const PassAccess& access : passes[i].accesses) {
+            Resource& resource = resources[access.resource];
+            if (resource.firstPass == NoPass) {
+                resource.firstPass = i;
+            }
+            resource.lastPass = i;
+        }
+    }
+}
+
+// Greedy interval packing, largest resources first: each transient joins the first slot of its type
+// with compatible memory whose members are all dead before it starts or born after it ends.
+void RenderGraph::assignAliasSlots() {
+    aliasSlots.clear();
+    std::vector<RenderResource> candidates;
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (!resource.imported && resource.firstPass != NoPass && resource.memory.size > 0) {
+            candidates.emplace_back(i);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [this](RenderResource a, RenderResource b) {
+        return resources[a].memory.size > resources[b].memory.size;
+    });
+
+    for (const RenderResource candidate : candidates) {
+        Resource& resource = resources[candidate];
+        for (size_t slot = 0; slot < aliasSlots.size() && resource.aliasSlot < 0; slot++) {
+            AliasSlot& aliasSlot = aliasSlots[slot];
+            if (aliasSlot.type != resource.type || (aliasSlot.memory.typeBits & resource.memory.typeBits) == 0) {
+                continue;
+            }
+            const bool disjoint = std::none_of(aliasSlot.resources.begin(), aliasSlot.resources.end(), [&](RenderResource member) {
+                return overlaps(resources[member].firstPass, resources[member].lastPass, resource.firstPass, resource.lastPass);
+            });
+            if (disjoint) {
+                aliasSlot.memory.size = std::max(aliasSlot.memory.size, resource.memory.size);
+                aliasSlot.memory.alignment = std::max(aliasSlot.memory.alignment, resource.memory.alignment);
+                aliasSlot.memory.typeBits &= resource.memory.typeBits;
+                aliasSlot.resources.emplace_back(candidate);
+                resource.aliasSlot = static_cast<int32_t>(slot);
+            }
+        }
+        if (resource.aliasSlot < 0) {
+            aliasSlots.emplace_back(AliasSlot{resource.type, resource.memory, {candidate}});
+            resource.aliasSlot = static_cast<int32_t>(aliasSlots.size() - 1);
+        }
+    }
+}
+
+// Tracks the last write and the reads since then for every resource. A write waits for those reads,
+// or for the last write when nothing read it. A read only waits for the last write if no earlier
+// read from the same stages already did. Texture layout changes always need a barrier.
+void RenderGraph::computeBarriers() {
+    struct State {
+        AccessMask lastWrite = 0;
+        AccessMask reads = 0;
+        TextureLayout layout = TextureLayout::Undefined;
+        bool started = false;
+    };
+
+    std::vector<State> states(resources.size());
+    for (size_t i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (!resource.imported) {
+            continue;
+        }
+        State& state = states[i];
+        state.started = true;
+        if (resource.initialAccess & WriteAccesses) {
+            state.lastWrite = resource.initialAccess;
+        } else {
+            state.reads = resource.initialAccess;
+        }
+        state.layout = resource.discard ? TextureLayout::Undefined : textureLayoutFor(resource.initialAccess);
+    }
+
+    // The accesses that last touched each alias slot, which its next occupant has to wait for.
+    std::vector<AccessMask> slotAccesses(aliasSlots.size(), 0);
+
+    auto transition = [&](RenderResource index, AccessMask access) {
+        const Resource& resource = resources[index];
+        State& state = states[index];
+        ResourceBarrier barrier{index, 0, access, state.layout, state.layout};
+        bool needed = false;
+
+        if (!state.started) {
+            state.started = true;
+            if (resource.aliasSlot >= 0) {
+                barrier.before = slotAccesses[resource.aliasSlot];
+                needed = barrier.before != 0;
+            }
+        }
+
+        const bool writes = (access & WriteAccesses) != 0;
+        if (writes) {
+            const AccessMask prior = state.reads ? state.reads : state.lastWrite;
+            barrier.before |= prior;
+            needed = needed || prior != 0;
+        } else if (state.lastWrite && (access & ~state.reads)) {
+            barrier.before |= state.lastWrite;
+            needed = true;
+        }
+
+        if (resource.type == RenderResourceType::Texture) {
+            barrier.newLayout = textureLayoutFor(access);
+            if (barrier.newLayout != state.layout) {
+                barrier.before |= state.lastWrite | state.reads;
+                needed = true;
+                state.reads = 0;
+            }
+            state.layout = barrier.newLayout;
+        }
+
+        if (writes) {
+            state.lastWrite = access;
+            state.reads = 0;
+        } else {
+            state.reads |= access;
+        }
+        return needed ? std::optional<ResourceBarrier>{barrier} : std::nullopt;
+    };
+
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        Pass& pass = passes[i];
+        pass.barriers.clear();
+        if (pass.culled) {
+            continue;
+        }
+        for (const PassAccess& access : pass.accesses) {
+            if (auto barrier = transition(access.resource, access.access)) {
+                pass.barriers.emplace_back(*barrier);
+            }
+            const Resource& resource = resources[access.resource];
+            if (resource.aliasSlot >= 0 && resource.lastPass == i) {
+                slotAccesses[resource.aliasSlot] = states[access.resource].lastWrite | states[access.resource].reads;
+            }
+        }
+    }
+
+    finalBarriers.clear();
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        if (resources[i].output) {
+            if (auto barrier = transition(i, resources[i].finalAccess)) {
+                finalBarriers.emplace_back(*barrier);
+            }
+        }
+    }
+}
+
+}